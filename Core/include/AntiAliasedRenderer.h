@@ -0,0 +1,72 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "Raster.h"
+#include "SdfRaster.h"
+
+#include <cstdint>
+#include <vector>
+
+class TaskScheduler;
+
+/// <summary>
+/// Anti-aliased counterpart of TileRenderer: sticks are capsules and circles with sub-pixel positions,
+/// blended by their distance field coverage (utils::BlendCapsuleSpan). Primitives are binned into square
+/// screen tiles, each tile blends its primitives in submission order and tiles are rendered in parallel.
+/// Only the rows and spans the shapes can reach are evaluated, see utils::Capsule.
+/// </summary>
+class AntiAliasedRenderer {
+public:
+    explicit AntiAliasedRenderer(int tileSize = 64) : m_tileSize(tileSize) {}
+
+    /// <summary>
+    /// Drops every queued primitive, keeping the buffers for the next batch
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Queues a capsule of the given radius around the segment [a, b]
+    /// </summary>
+    void AddCapsule(const olc::vf2d& a, const olc::vf2d& b, float radius, const olc::Pixel& color);
+
+    void AddCircle(const olc::vf2d& center, float radius, const olc::Pixel& color) { AddCapsule(center, center, radius, color); }
+
+    /// <summary>
+    /// Queues the smooth version of what DrawStickShape draws for a stick, with line widths and radii
+    /// multiplied by scale. start and tip are expected already scaled.
+    /// </summary>
+    void AddStickShape(
+        const olc::vf2d& start, const olc::vf2d& tip,
+        bool isCircle,
+        const olc::Pixel& color,
+        float scale = 1.0f,
+        bool selected = false
+    );
+
+    size_t PrimitiveCount() const { return m_primitives.size(); }
+
+    /// <summary>
+    /// Blends the queued primitives into a buffer of width x height pixels, pitch pixels per row.
+    /// Tiles are spread over the scheduler; pixels outside every primitive are left alone.
+    /// The buffer can be a window into a larger target, starting at origin in the primitives' coordinates.
+    /// </summary>
+    void Render(TaskScheduler& scheduler, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin = { 0, 0 });
+    void Render(TaskScheduler& scheduler, olc::Sprite& target);
+
+private:
+    struct Primitive {
+        utils::Capsule reach; // the pixels with any coverage
+        utils::SdfCapsule shape;
+        int left, right; // inclusive column bounds, rows are in reach
+        olc::Pixel color;
+    };
+
+    void RenderTile(int tileX, int tileY, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) const;
+
+    int m_tileSize;
+    std::vector<Primitive> m_primitives;
+
+    // primitive indices per tile, in submission order
+    int m_tilesX{ 0 }, m_tilesY{ 0 };
+    std::vector<std::vector<uint32_t>> m_bins;
+};
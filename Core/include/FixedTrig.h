@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Utility.h"
+
+#include <cstdint>
+
+namespace utils {
+    // Angles in fixed-point mode are integers, AngleUnitsPerTurn per full turn
+    constexpr int32_t AngleUnitsPerTurn = 1 << 16;
+
+    // Whether poses are evaluated with integer angles and the sine table below.
+    // Fixed-point poses are bit-identical across compilers, flags and optimization levels.
+    bool GetFixedPointMode();
+    void SetFixedPointMode(bool enabled);
+
+    // Nearest angle unit to an angle in radians (ties to even), and back. The latter is inline so batched loops vectorize.
+    int32_t ToAngleUnits(double radians);
+    inline double FromAngleUnits(int32_t units) { return double(units) * (2.0 * Pi / AngleUnitsPerTurn); }
+
+    // Nearest Q16 value (1 << 16 is 1.0), ties to even
+    int32_t ToFixedQ16(double value);
+
+    // Sine and cosine of an angle in units as Q30 fixed point (1 << 30 is 1.0), read from a table
+    // generated with integer math only
+    int32_t SinQ30(int32_t units);
+    int32_t CosQ30(int32_t units);
+    void SinCosQ30(int32_t units, int32_t& sine, int32_t& cosine);
+
+    // Signed difference from startAngle to endAngle in units along the shortest path.
+    // Exactly half a turn counts as forward, like utils::ShortestAngleDelta.
+    int32_t AngleUnitsDelta(int32_t startAngle, int32_t endAngle);
+
+    // Interpolates between two angles in units along the shortest path, t in Q16 (1 << 16 is 1.0)
+    int32_t LerpAngleUnits(int32_t startAngle, int32_t endAngle, int32_t t);
+
+    // Interpolates between two integers, t in Q16, rounding toward start. Inline so batched loops vectorize.
+    inline int32_t LerpQ16(int32_t start, int32_t end, int64_t t) { return start + int32_t(int64_t(end - start) * t / (1 << 16)); }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "Stick.h"
+#include "TileRenderer.h"
+#include "AntiAliasedRenderer.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class TaskScheduler;
+
+/// <summary>
+/// Draws figures into a plain pixel buffer or sprite, without a PixelGameEngine, a window or a GL context.
+/// By default the pixels are the same as drawing the figures through the engine, see TileRenderer.
+/// Without a scheduler everything runs on the calling thread.
+/// Tools linking StickMatorHeadless get it without the platform layer (no X11, GL or libpng).
+/// Anti-aliased rendering draws smooth sub-pixel shapes instead, and can scale the figures up for high resolution output.
+/// </summary>
+class OffscreenRenderer {
+public:
+    explicit OffscreenRenderer(TaskScheduler* scheduler = nullptr, int tileSize = 64);
+    ~OffscreenRenderer();
+
+    void SetBackground(const olc::Pixel& color) { m_background = color; }
+    const olc::Pixel& GetBackground() const { return m_background; }
+
+    void SetAntiAliased(bool antiAliased) { m_antiAliased = antiAliased; }
+    bool IsAntiAliased() const { return m_antiAliased; }
+
+    /// <summary>
+    /// Scale of the figures around the canvas origin, used by anti-aliased rendering only
+    /// </summary>
+    void SetScale(float scale) { m_scale = scale; }
+    float GetScale() const { return m_scale; }
+
+    /// <summary>
+    /// Clears a buffer of width x height RGBA pixels, pitch pixels per row, to the background
+    /// and draws the figures in their current pose, in order
+    /// </summary>
+    void Render(const std::vector<std::shared_ptr<Figure>>& figures, olc::Pixel* pixels, int width, int height, size_t pitch);
+    void Render(const std::vector<std::shared_ptr<Figure>>& figures, olc::Sprite& target);
+
+    /// <summary>
+    /// Renders frames [0, frameCount) of the figures' animation into the target, calling onFrame after each one.
+    /// Playback starts from the current pose like the editor's, and the figures are put back in it afterwards.
+    /// </summary>
+    void RenderAnimation(
+        const std::vector<std::shared_ptr<Figure>>& figures,
+        olc::Sprite& target,
+        int frameCount,
+        const std::function<void(int frame)>& onFrame
+    );
+
+private:
+    std::unique_ptr<TaskScheduler> m_ownScheduler;
+    TaskScheduler* m_scheduler;
+    TileRenderer m_tiles;
+    AntiAliasedRenderer m_smooth;
+    olc::Pixel m_background{ olc::WHITE };
+    bool m_antiAliased{ false };
+    float m_scale{ 1.0f };
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Stick.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Baked poses of a set of figures for every frame, in one contiguous buffer laid out
+/// frame by frame, so playback only has to copy a row instead of interpolating keyframes.
+/// Baking replays the same sequential evaluation as live playback from frame 0, and keyframe
+/// edits only re-bake the frame range they can affect on the figure that changed. A pose edited by hand
+/// (see Figure::InvalidatePose) re-bakes its figure from the edited pose.
+/// Figures are told apart by their rig revision, unique to every compiled rig, not only by address.
+/// </summary>
+class PoseCache {
+public:
+    /// <summary>
+    /// Brings the buffer up to date with the figures and frame count, re-baking only stale ranges
+    /// </summary>
+    void Update(const std::vector<std::shared_ptr<Figure>>& figures, int frameCount);
+
+    /// <summary>
+    /// Baked pose of a figure at a frame, in rig order
+    /// </summary>
+    /// <returns>nullptr if the figure or frame isn't baked</returns>
+    const StickPose* GetPose(const Figure& figure, int frame) const;
+
+    /// <summary>
+    /// Poses the figure's sticks from the buffer
+    /// </summary>
+    /// <returns>false if the figure or frame isn't baked</returns>
+    bool Apply(Figure& figure, int frame) const;
+
+    /// <summary>
+    /// Poses the figure's sticks at a fractional time, blending the baked frame floor(time) into the next one
+    /// like Figure::Animate(float) interpolates keyframes. Whole times behave exactly like Apply(figure, frame).
+    /// The root's position may differ from Figure::Animate(float) by a pixel, it is blended from whole pixels.
+    /// In the last segment of a track the next row holds, so the blend holds as whole-frame playback does.
+    /// </summary>
+    /// <returns>false if the figure or frame isn't baked</returns>
+    bool Apply(Figure& figure, float time) const;
+
+    void Clear();
+
+    int FrameCount() const { return m_frameCount; }
+
+private:
+    struct Slot {
+        Figure* figure;
+        uint64_t rigRevision;
+        size_t offset, count;
+        int staleFirst, staleLast;
+    };
+
+    void Rebuild(const std::vector<std::shared_ptr<Figure>>& figures, int frameCount);
+    void Bake(Slot& slot, int first, int last);
+
+    std::vector<Slot> m_slots;
+    std::unordered_map<const Figure*, size_t> m_slotIndex;
+
+    // pose of every figure before frame 0, then one row of m_stride poses per frame
+    std::vector<StickPose> m_rest;
+    std::vector<StickPose> m_poses;
+
+    size_t m_stride{ 0 };
+    int m_frameCount{ 0 };
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+
+namespace utils {
+    // A thick segment with round caps. Pixel (x, y) is covered when its center, at integer
+    // coordinates, lies within radius of the segment [a, b]. The covered pixels of a row are
+    // always one run, so the shape is drawn as horizontal spans touching each pixel once.
+    struct Capsule {
+        Capsule(const olc::vd2d& a, const olc::vd2d& b, float radius);
+
+        // rows that can hold covered pixels, inclusive
+        int top, bottom;
+
+        // Covered pixels [x0, x1] of row y, false if there are none
+        bool Span(int y, int& x0, int& x1) const;
+
+        double ax, ay, bx, by;
+        double radius, radiusSq;
+
+        // the body's row span is linear in y: x in [m + k * y, ...] for each of its four edges,
+        // precomputed so a row costs a few multiply-adds
+        bool hasBody;
+        double projLoBase, projHiBase, projSlope; // projection onto the segment within [0, length^2]
+        double sideLoBase, sideHiBase, sideSlope; // distance to the segment's line within radius
+        bool projFlat, sideFlat; // the segment is vertical / horizontal, the edge doesn't depend on x
+        double dx, dy, lengthSq, reach;
+    };
+
+    // Sets pixels [x0, x1] of row y of the draw target, clipped to it. Writes straight into the
+    // target in Pixel::NORMAL mode, otherwise goes through PixelGameEngine::Draw for blending.
+    void FillSpan(olc::PixelGameEngine* pge, int y, int x0, int x1, const olc::Pixel& color);
+
+    void FillCapsule(olc::PixelGameEngine* pge, const olc::vi2d& a, const olc::vi2d& b, float radius, const olc::Pixel& color);
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+
+#include <cstdint>
+#include <vector>
+
+struct Stick;
+struct StickPose;
+class TileRenderer;
+class AntiAliasedRenderer;
+
+enum RigFlags : uint8_t {
+    RigCircle = 1 << 0,
+    RigVisible = 1 << 1,
+    RigDriver = 1 << 2,
+    RigDriven = 1 << 3
+};
+
+/// <summary>
+/// What DrawStickShape draws for one stick, for renderers that keep shapes around between frames
+/// </summary>
+struct StickShape {
+    olc::vf2d start, tip; // whole pixels unless collected at sub-pixel precision
+    int length;
+    bool isCircle;
+    olc::Pixel color;
+
+    bool operator==(const StickShape& other) const = default;
+};
+
+/// <summary>
+/// The part of a compiled rig that only changes with Compile: topology and per-stick constants.
+/// </summary>
+struct RigDefinition {
+    std::vector<int> parent;
+    std::vector<int> length;
+    std::vector<olc::Pixel> color;
+    std::vector<int> drawOrder;
+    std::vector<uint8_t> flags;
+    std::vector<int> driver;
+    std::vector<float> driverInfluence;
+    std::vector<float> driverAngleOffset; // radians
+
+    // driven sticks after their drivers, so driver chains resolve in one sweep
+    std::vector<int> driveOrder;
+
+    // stick indices sorted by draw order
+    std::vector<int> drawList;
+
+    size_t Size() const { return parent.size(); }
+};
+
+/// <summary>
+/// Compiled structure-of-arrays form of a stick tree.
+/// Every array is indexed the same way, in topological order (parents before children),
+/// so evaluation is a single linear sweep without pointer chasing.
+/// The Stick tree stays the editing front-end and is re-compiled on structural changes.
+/// </summary>
+struct Rig {
+    // topology and per-stick constants
+    RigDefinition definition;
+
+    // local pose, pulled from the sticks every frame
+    std::vector<olc::vi2d> pos;
+    std::vector<double> angle;
+
+    // evaluated transforms
+    std::vector<double> localAngle; // after drivers
+    std::vector<int32_t> localUnits, worldUnits; // fixed-point mode only, empty until then
+    std::vector<olc::vi2d> worldPos;
+    std::vector<double> worldAngle;
+    std::vector<olc::vi2d> tip;
+
+    // editing front-end, one per index
+    std::vector<Stick*> sticks;
+
+    // the draw order as stick pointers, all and visible only, for the editors
+    std::vector<Stick*> drawSticks;
+    std::vector<Stick*> visibleDrawSticks;
+
+    size_t Size() const { return sticks.size(); }
+
+    /// <summary>
+    /// Flattens the tree under root into the definition and the arrays above.
+    /// Never fails: if the drivers form a cycle, one link of the cycle is cut in the tree.
+    /// </summary>
+    /// <param name="root"></param>
+    void Compile(Stick* root);
+
+    /// <summary>
+    /// Copies the local position and angle of every stick into the rig
+    /// </summary>
+    void Pull();
+
+    /// <summary>
+    /// Copies a pose in rig order into the rig, without going through the sticks
+    /// </summary>
+    void Pull(const StickPose* pose);
+
+    /// <summary>
+    /// Computes world positions, angles and tips from the local pose
+    /// </summary>
+    void Evaluate();
+
+    /// <summary>
+    /// Evaluate() with integer angles and table trigonometry, see utils::GetFixedPointMode
+    /// </summary>
+    void EvaluateFixed();
+
+    /// <summary>
+    /// Writes the evaluated world transforms back into the sticks' caches
+    /// </summary>
+    void Push() const;
+
+    void Draw(
+        olc::PixelGameEngine* pge,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const;
+
+    /// <summary>
+    /// Queues the same shapes as Draw(pge, ...) into a tile renderer
+    /// </summary>
+    void Draw(
+        TileRenderer& renderer,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const;
+
+    /// <summary>
+    /// Appends the shapes Draw would draw, in draw order. At sub-pixel precision positions are chained
+    /// in floats from the world angles instead of the truncated integer tips.
+    /// </summary>
+    void CollectShapes(
+        std::vector<StickShape>& out,
+        bool subPixel = false,
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const;
+
+    /// <summary>
+    /// Queues smooth shapes into an anti-aliased renderer, collected at sub-pixel precision and scaled
+    /// around the rig's origin
+    /// </summary>
+    void Draw(
+        AntiAliasedRenderer& renderer,
+        const olc::vf2d& offset = { 0.0f, 0.0f },
+        float scale = 1.0f,
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const;
+};
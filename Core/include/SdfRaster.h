@@ -0,0 +1,22 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+
+namespace utils {
+    // A thick segment with round caps and sub-pixel end points, shaded from its signed distance field.
+    // Pixels are sampled at their centers, on integer coordinates like Capsule, and a pixel at distance d
+    // from the segment [a, b] is covered by clamp(radius + 0.5 - d, 0, 1), a one pixel wide ramp
+    // across the edge. A circle is a capsule with a == b.
+    struct SdfCapsule {
+        SdfCapsule(const olc::vf2d& a, const olc::vf2d& b, float radius);
+
+        float ax, ay, dx, dy;
+        float invLengthSq; // 0 for a circle, every pixel then projects onto a
+        float radius;
+    };
+
+    // Blends color into pixels [x0, x1] of row y, stored from span on, each weighted by how much of it the capsule covers
+    // (times the color's alpha). The coverage is evaluated 8 pixels at a time with AVX2, 4 with SSE4.1,
+    // following GetSimdLevel. The paths do the same float operations in the same order.
+    void BlendCapsuleSpan(olc::Pixel* span, int y, int x0, int x1, const SdfCapsule& capsule, const olc::Pixel& color);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+
+#include <cstddef>
+
+namespace utils {
+    enum class SimdLevel {
+        Scalar = 0,
+        SSE4,
+        AVX2
+    };
+
+    // Instruction set picked at runtime for the batched kernels
+    SimdLevel GetSimdLevel();
+
+    // Forces a specific path (clamped to what the CPU supports), mostly for debugging
+    void SetSimdLevel(SimdLevel level);
+
+    // Computes tips[i] = (cos(angles[i]) * lengths[i], sin(angles[i]) * lengths[i]) truncated to integers,
+    // matching the scalar std::cos/std::sin results. Sticks with lengths[i] <= 0 get a zero tip.
+    void ComputeTips(const double* angles, const int* lengths, olc::vi2d* tips, size_t count);
+}
@@ -8,8 +8,13 @@
 #endif
 
 #include "CommandFile.h"
+#include "Rig.h"
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 struct StickKeyframe {
     int frame;
@@ -17,6 +22,21 @@ struct StickKeyframe {
     double angle;
 };
 
+struct StickPose {
+    olc::vi2d pos;
+    double angle;
+};
+
+/// <summary>
+/// Snapshot of the local pose of a figure, one StickPose per stick in rig order.
+/// It's a plain value, independent of the sticks, so any number of them can be kept at once.
+/// </summary>
+struct Pose {
+    std::vector<StickPose> sticks;
+
+    size_t Size() const { return sticks.size(); }
+};
+
 enum class MotionType {
     None = 0,
     Normal,
@@ -29,6 +49,8 @@ enum class ManipulatorMode {
     Rotate
 };
 
+struct Figure;
+
 struct Stick {
     size_t id{ 0 };
 
@@ -45,9 +67,12 @@ struct Stick {
 
     MotionType motionType{ MotionType::Normal };
 
-    olc::vi2d tempPos;
-    double tempAngle;
+    // world transform cache, refreshed top-down by UpdateTransforms()
+    olc::vi2d cachedWorldPos{ 0, 0 };
+    olc::vi2d cachedTip{ 0, 0 };
+    double cachedWorldAngle{ 0.0 };
 
+    Figure* figure{ nullptr };
     Stick* parent{ nullptr };
     std::vector<std::unique_ptr<Stick>> children;
 
@@ -56,6 +81,7 @@ struct Stick {
     float driverAngleOffset{ 0.0f };
 
     std::vector<StickKeyframe> animation{};
+    size_t animCursor{ 0 }; // segment hit by the last Animate call
 
     Stick& AddChild(int len, double angle, MotionType motionType = MotionType::Normal, bool isCircle = false);
     void RemoveChild(Stick* stick);
@@ -66,25 +92,66 @@ struct Stick {
     olc::vi2d WorldPos() const;
     void SetWorldPos(olc::vi2d newPos);
     double Angle() const;
+
+    /// <summary>
+    /// Angle() in fixed-point angle units, through the drivers the same way as Rig::EvaluateFixed
+    /// </summary>
+    int32_t AngleUnits() const;
     double WorldAngle() const;
     void SetWorldAngle(double newAngle, bool compensateChildren = false);
 
+    /// <summary>
+    /// Recomputes the cached world transform of this stick and its children, in fixed point
+    /// when utils::GetFixedPointMode is on, matching the compiled rig either way.
+    /// Expects the parent's cache to be up to date.
+    /// </summary>
+    void UpdateTransforms();
+
     bool HasAnimation(int frame) const;
-    bool HasAnimationRecursive(int frame);
 
     void Animate(int frame);
 
+    /// <summary>
+    /// The keyframed pose at a frame, like Animate(int) but written to pose instead of the stick.
+    /// Leaves pose alone where Animate would leave the stick alone, and the root is the only stick whose position is animated.
+    /// </summary>
+    /// <returns>Whether the frame is inside the track</returns>
+    bool Sample(int frame, StickPose& pose) const;
+
+    /// <summary>
+    /// Same as Animate(int), at a fractional time in frames
+    /// </summary>
+    void Animate(float time);
+
     void SetKeyframe(int frame);
     void SetKeyframeSingle(int frame, const olc::vi2d& pos, double angle);
-    void DeleteKeyframe(int frame);
 
-    int MaxFrames() const;
+    /// <summary>
+    /// Appends a keyframe without keeping the track sorted, for bulk loading.
+    /// Call SortKeyframes once all keyframes are in.
+    /// </summary>
+    void AppendKeyframe(int frame, const olc::vi2d& pos, double angle);
+    void SortKeyframes();
+
+    /// <summary>
+    /// Tells the figure which frames a keyframe edit at this frame can affect
+    /// </summary>
+    void NotifyKeyframeChanged(int frame);
+    void DeleteKeyframe(int frame);
 
     int NearFrameLeft(int frame) const;
     int NearFrameRight(int frame) const;
 
-    void SaveState();
-    void RestoreState();
+    /// <summary>
+    /// Finds the keyframe pair bracketing a frame
+    /// </summary>
+    /// <returns>Index of the segment's first keyframe, or -1 when outside the track</returns>
+    int FindSegment(int frame) const;
+
+    /// <summary>
+    /// Same as FindSegment, but starts from the cursor so forward playback and scrubbing are O(1)
+    /// </summary>
+    int SeekSegment(int frame);
 
     void Draw(
         olc::PixelGameEngine* pge,
@@ -105,8 +172,11 @@ struct Stick {
     );
 
     std::vector<Stick*> GetSticksRecursive();
-    std::vector<Stick*> GetSticksRecursiveSorted();
-    std::vector<Stick*> GetSticksRecursiveVisibleSorted();
+
+    /// <summary>
+    /// Whether the given stick can drive this one without closing a driver cycle
+    /// </summary>
+    bool CanBeDrivenBy(const Stick* stick) const;
 
     bool IsDriven() const { return driver != nullptr && std::abs(driverInfluence) > 1e-5f; }
     bool canMove() const { return motionType != MotionType::None && !IsDriven() && isVisible; }
@@ -114,14 +184,237 @@ struct Stick {
     static int gStickId;
 };
 
+void DrawStickShape(
+    olc::PixelGameEngine* pge,
+    const olc::vi2d& start, const olc::vi2d& tip,
+    int len, bool isCircle,
+    const olc::Pixel& color,
+    bool selected = false
+);
+
 struct Figure {
     int id{ 0 };
 
     std::string name;
+
     std::unique_ptr<Stick> root;
 
+    // what the last LoadFromCommands left out because it couldn't be used, one message per command.
+    // Saving writes the figure as loaded, so callers should show these before the file is overwritten
+    std::vector<std::string> loadWarnings;
+
+    Rig rig;
+    bool rigDirty{ true };
+    // set by every Compile from a counter shared by all figures, so a rig is never mistaken
+    // for another one, even from a figure allocated where a deleted one used to be
+    uint64_t rigRevision{ 0 };
+
+    // changed by UpdateTransforms whenever the evaluated pose may differ from the previous call's,
+    // i.e. another local pose, rig or evaluation mode. Unique across figures like rigRevision
+    uint64_t transformRevision{ 0 };
+    std::vector<StickPose> transformedPose;
+    uint64_t transformedRigRevision{ 0 };
+    bool transformedFixedPoint{ false };
+    // false once DrawPose or CollectPoseShapes evaluated another pose in the rig's arrays
+    bool rigHoldsLivePose{ false };
+
+    // bumped on every keyframe or structure change
+    unsigned animationRevision{ 0 };
+
+    // what the sticks currently hold, so Animate can skip redundant work
+    bool poseEvaluated{ false };
+    int evaluatedFrame{ 0 };
+    unsigned evaluatedRevision{ 0 };
+
+    // frames in [keyRangeFirst, keyRangeLast) can move at least one stick, as of keyRangeRevision
+    int keyRangeFirst{ 0 }, keyRangeLast{ 0 };
+    unsigned keyRangeRevision{ ~0u };
+
+    // frames [staleFirst, staleLast) whose baked pose is out of date, consumed by PoseCache
+    int staleFirst{ 0 }, staleLast{ 0 };
+    // the pose was edited by hand since PoseCache captured the pose its bake starts from
+    bool restStale{ false };
+
+    // keyed frame -> number of sticks with a keyframe there
+    std::map<int, int> keyedFrames;
+
+    // id -> stick, for every stick attached under root
+    std::unordered_map<size_t, Stick*> stickIndex;
+
+    static std::atomic<uint64_t> gRigRevision;
+    static std::atomic<uint64_t> gTransformRevision;
+
     Figure() {}
 
+    /// <summary>
+    /// Replaces the stick tree with a bare root stick
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Marks the compiled rig as stale after a structural edit
+    /// </summary>
+    void Invalidate();
+
+    /// <summary>
+    /// Called by sticks whenever one of their keyframes is added, edited or removed
+    /// </summary>
+    /// <param name="first">First frame whose pose may have changed</param>
+    /// <param name="last">One past the last frame whose pose may have changed</param>
+    void KeyframesChanged(int first, int last);
+
+    /// <summary>
+    /// Finds a stick of this figure by id
+    /// </summary>
+    /// <returns>nullptr if no attached stick has that id</returns>
+    Stick* FindStick(size_t id) const;
+
+    /// <summary>
+    /// Adds or removes a stick and its children from the id index, called as sticks are attached and detached
+    /// </summary>
+    void IndexSticks(Stick* stick);
+    void UnindexSticks(Stick* stick);
+
+    /// <summary>
+    /// Keeps the keyed frame index in sync, called by sticks as keyframes come and go
+    /// </summary>
+    void KeyAdded(int frame);
+    void KeyRemoved(int frame);
+
+    /// <summary>
+    /// Last keyed frame of the figure, read from the keyed frame index
+    /// </summary>
+    int MaxFrames() const;
+
+    /// <summary>
+    /// Whether any stick of the figure has a keyframe at the given frame
+    /// </summary>
+    bool IsFrameKeyed(int frame) const;
+
+    /// <summary>
+    /// Closest keyed frame after the given frame
+    /// </summary>
+    /// <returns>-1 if there is none</returns>
+    int NextKeyedFrame(int frame) const;
+
+    /// <summary>
+    /// Closest keyed frame before the given frame
+    /// </summary>
+    /// <returns>-1 if there is none</returns>
+    int PrevKeyedFrame(int frame) const;
+
+    /// <summary>
+    /// Returns the stale frame range and clears it
+    /// </summary>
+    std::pair<int, int> TakeStaleFrames();
+
+    /// <summary>
+    /// Forces the next Animate call to re-apply keyframes, e.g. after the pose was edited by hand.
+    /// Baked poses are re-baked from the edited pose, so sticks outside their tracks keep it there too.
+    /// </summary>
+    void InvalidatePose();
+
+    /// <summary>
+    /// Poses every stick for the given frame. Does nothing if the sticks already hold that frame
+    /// and no keyframe changed since, or if no track covers the frame.
+    /// </summary>
+    /// <returns>Whether any stick was animated</returns>
+    bool Animate(int frame);
+
+    /// <summary>
+    /// Poses every stick at a fractional time in frames, interpolating between keys.
+    /// Whole times behave exactly like Animate(int).
+    /// </summary>
+    /// <returns>Whether any stick was animated</returns>
+    bool Animate(float time);
+
+    /// <summary>
+    /// Recomputes the key range if a keyframe changed since it was last computed
+    /// </summary>
+    void UpdateKeyRange();
+
+    /// <summary>
+    /// Flattens the stick tree into the rig
+    /// </summary>
+    void Compile();
+
+    /// <summary>
+    /// The compiled rig, re-compiled first if the tree changed
+    /// </summary>
+    Rig& GetRig();
+
+    /// <summary>
+    /// Every stick sorted by draw order. Cached in the rig, so it stays valid until the next structural edit.
+    /// </summary>
+    const std::vector<Stick*>& GetSticksSorted() { return GetRig().drawSticks; }
+
+    /// <summary>
+    /// Visible sticks sorted by draw order, cached like GetSticksSorted
+    /// </summary>
+    const std::vector<Stick*>& GetSticksVisibleSorted() { return GetRig().visibleDrawSticks; }
+
+    /// <summary>
+    /// Copies the local pose of every stick, in rig order
+    /// </summary>
+    void CapturePose(StickPose* out);
+
+    /// <summary>
+    /// Sets the local pose of every stick from a buffer in rig order
+    /// </summary>
+    void ApplyPose(const StickPose* pose);
+
+    /// <summary>
+    /// Copies the local pose of every stick into a snapshot
+    /// </summary>
+    void CapturePose(Pose& out);
+
+    /// <summary>
+    /// Sets the local pose of every stick from a snapshot. Throws if it was taken from a different stick tree.
+    /// </summary>
+    void ApplyPose(const Pose& pose);
+
+    /// <summary>
+    /// Evaluates the keyframes at a frame into a snapshot without touching the sticks.
+    /// Sticks not animated at that frame keep their live pose, same as after Animate.
+    /// </summary>
+    void EvaluatePose(int frame, Pose& out);
+
+    /// <summary>
+    /// Evaluates frames [first, last) for every stick in one go, as sequential Animate calls from frame first would.
+    /// Row f - first of out holds frame f, stride poses per row (rig size if 0) with this figure's sticks at the start
+    /// in rig order. A stick outside its track holds its pose from the frame before, or from start on the first frame.
+    /// The sticks themselves are left alone.
+    /// </summary>
+    void EvaluateRange(int first, int last, const StickPose* start, StickPose* out, size_t stride = 0);
+
+    /// <summary>
+    /// Draws the figure in the given pose (in rig order) instead of the live one.
+    /// The sticks and their cached world transforms are left alone.
+    /// </summary>
+    void DrawPose(
+        olc::PixelGameEngine* pge,
+        const StickPose* pose,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    );
+    void DrawPose(
+        olc::PixelGameEngine* pge,
+        const Pose& pose,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) { DrawPose(pge, pose.sticks.data(), offset, colorOverride); }
+
+    /// <summary>
+    /// Appends the shapes DrawPose would draw for the given pose (in rig order), see Rig::CollectShapes.
+    /// The sticks and their cached world transforms are left alone.
+    /// </summary>
+    void CollectPoseShapes(
+        const StickPose* pose,
+        std::vector<StickShape>& out,
+        bool subPixel = false,
+        const olc::Pixel& colorOverride = olc::BLANK
+    );
+
     /// <summary>
     /// Loads a stick figure from a string
     /// </summary>
@@ -136,6 +429,51 @@ struct Figure {
 
     void LoadFromCommands(const std::vector<Command>& commands);
 
+    /// <summary>
+    /// Loads every figure of an animation file (.stk), in file order. Figure ids are left to the caller.
+    /// </summary>
+    static std::vector<std::shared_ptr<Figure>> LoadAnimation(const std::string& fileName);
+
+    /// <summary>
+    /// Evaluates the world transforms of every stick in a single top-down pass, see transformRevision.
+    /// Returns right away if the rig already holds the evaluation of the sticks' current pose.
+    /// </summary>
+    void UpdateTransforms();
+
+    void Draw(
+        olc::PixelGameEngine* pge,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const;
+
+    /// <summary>
+    /// Queues the figure into a tile renderer, drawn from the last UpdateTransforms like Draw(pge, ...)
+    /// </summary>
+    void Draw(
+        TileRenderer& renderer,
+        const olc::vi2d& offset = { 0, 0 },
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const { rig.Draw(renderer, offset, colorOverride); }
+
+    /// <summary>
+    /// Queues the figure into an anti-aliased renderer at sub-pixel precision, scaled by scale, see Rig::Draw
+    /// </summary>
+    void Draw(
+        AntiAliasedRenderer& renderer,
+        const olc::vf2d& offset = { 0.0f, 0.0f },
+        float scale = 1.0f,
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const { rig.Draw(renderer, offset, scale, colorOverride); }
+
+    /// <summary>
+    /// Appends the shapes Draw would draw from the last UpdateTransforms, see Rig::CollectShapes
+    /// </summary>
+    void CollectShapes(
+        std::vector<StickShape>& out,
+        bool subPixel = false,
+        const olc::Pixel& colorOverride = olc::BLANK
+    ) const { rig.CollectShapes(out, subPixel, colorOverride); }
+
     /// <summary>
     /// Saves a stick figure to a file
     /// </summary>
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskScheduler;
+
+/// <summary>
+/// A set of tasks that can be waited on together.
+/// The first exception thrown by one of its tasks is rethrown by Wait().
+/// </summary>
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskScheduler& scheduler) : m_scheduler(scheduler) {}
+
+    // waits for the remaining tasks, dropping their exceptions
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// <summary>
+    /// Queues a task, or runs it right away in single-thread mode
+    /// </summary>
+    void Run(std::function<void()> task);
+
+    /// <summary>
+    /// Blocks until every task of the group has finished, running queued tasks meanwhile
+    /// </summary>
+    void Wait();
+
+private:
+    friend class TaskScheduler;
+
+    void Finish(std::exception_ptr error);
+
+    TaskScheduler& m_scheduler;
+    std::atomic<size_t> m_pending{ 0 };
+
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+};
+
+/// <summary>
+/// Work-stealing job system. Every worker has its own deque: it runs its own tasks newest first
+/// and, once out of work, steals the oldest tasks of the others, so split-up work spreads out by itself.
+/// Threads that aren't workers (e.g. the olc main thread) queue into a shared injection queue and
+/// help run tasks while they wait on a group.
+/// With a thread count of 0 the scheduler is single-threaded: tasks run inline, in order, on the caller.
+/// </summary>
+class TaskScheduler {
+public:
+    explicit TaskScheduler(size_t threadCount = DefaultThreadCount());
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /// <summary>
+    /// Restarts the scheduler with threadCount workers, 0 for single-thread mode.
+    /// Must not be called while tasks are queued or running.
+    /// </summary>
+    void SetThreadCount(size_t threadCount);
+
+    size_t ThreadCount() const { return m_workers.size(); }
+
+    bool IsSingleThreaded() const { return m_workers.empty(); }
+
+    /// <summary>
+    /// Calls body(i) for every i in [begin, end) and returns once all are done.
+    /// The range is split in halves down to grain sized chunks, which idle workers steal.
+    /// Items must not depend on each other; which thread runs an item is unspecified.
+    /// </summary>
+    void ParallelFor(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain = 1);
+
+    /// <summary>
+    /// Queues a continuation for the main thread, e.g. to hand the result of a background task to the UI.
+    /// Safe to call from any thread.
+    /// </summary>
+    void PostToMainThread(std::function<void()> task);
+
+    /// <summary>
+    /// Runs the continuations posted so far, call it once per frame from the main thread
+    /// </summary>
+    void RunMainThreadTasks();
+
+    // one less than the core count, the main thread being the last one
+    static size_t DefaultThreadCount();
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void Start(size_t threadCount);
+    void Stop();
+
+    void Push(Task&& task);
+    bool TryPop(Task& task);
+    bool TryRunOne();
+    void Execute(Task& task);
+    void WorkerLoop(size_t index);
+
+    // wakes up sleeping workers and waiting groups
+    void Notify(bool all);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    // tasks queued from threads that aren't workers
+    std::mutex m_injectMutex;
+    std::deque<Task> m_inject;
+
+    std::atomic<size_t> m_queued{ 0 };
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleep;
+    bool m_stop{ false };
+
+    std::mutex m_mainMutex;
+    std::vector<std::function<void()>> m_mainTasks;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "Raster.h"
+
+#include <cstdint>
+#include <vector>
+
+class TaskScheduler;
+
+/// <summary>
+/// Batches stick primitives, bins them into square screen tiles and rasterizes the tiles in parallel.
+/// Each tile draws its primitives in submission order with the same spans as the serial
+/// PixelGameEngine path (utils::FillCapsule, FillCircle in Pixel::NORMAL mode), so the output is pixel-identical.
+/// Primitives are opaque and simply overwrite the target.
+/// </summary>
+class TileRenderer {
+public:
+    explicit TileRenderer(int tileSize = 64) : m_tileSize(tileSize) {}
+
+    /// <summary>
+    /// Drops every queued primitive, keeping the buffers for the next batch
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Queues a capsule, see utils::Capsule
+    /// </summary>
+    void AddCapsule(const olc::vi2d& a, const olc::vi2d& b, float radius, const olc::Pixel& color);
+
+    /// <summary>
+    /// Queues a disc covering exactly what PixelGameEngine::FillCircle would
+    /// </summary>
+    void AddCircle(const olc::vi2d& center, int radius, const olc::Pixel& color);
+
+    /// <summary>
+    /// Queues what DrawStickShape draws for a stick
+    /// </summary>
+    void AddStickShape(
+        const olc::vi2d& start, const olc::vi2d& tip,
+        int len, bool isCircle,
+        const olc::Pixel& color,
+        bool selected = false
+    );
+
+    size_t PrimitiveCount() const { return m_primitives.size(); }
+
+    /// <summary>
+    /// Rasterizes the queued primitives into a buffer of width x height pixels, pitch pixels per row.
+    /// Tiles are spread over the scheduler; pixels outside every primitive are left alone.
+    /// The buffer can be a window into a larger target, starting at origin in the primitives' coordinates.
+    /// </summary>
+    void Render(TaskScheduler& scheduler, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin = { 0, 0 });
+    void Render(TaskScheduler& scheduler, olc::Sprite& target);
+
+private:
+    struct Primitive {
+        bool isCircle;
+        uint32_t index; // into m_capsules or m_circles
+        int left, top, right, bottom; // inclusive bounds
+        olc::Pixel color;
+    };
+
+    struct Circle {
+        int x, y, radius;
+        size_t rows; // offset of its 2 * radius + 1 row half-widths in m_circleRows, -1 marking an empty row
+    };
+
+    void RenderTile(int tileX, int tileY, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) const;
+
+    int m_tileSize;
+    std::vector<Primitive> m_primitives;
+    std::vector<utils::Capsule> m_capsules;
+    std::vector<Circle> m_circles;
+    std::vector<int> m_circleRows;
+
+    // primitive indices per tile, in submission order
+    int m_tilesX{ 0 }, m_tilesY{ 0 };
+    std::vector<std::vector<uint32_t>> m_bins;
+};
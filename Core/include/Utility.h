@@ -11,6 +11,9 @@ namespace utils {
     // Utility function to normalize an angle to the range [0, 2π)
     double NormalizeAngle(double angle);
 
+    // Signed difference from startAngle to endAngle along the shortest path, in (-π, π]
+    double ShortestAngleDelta(double startAngle, double endAngle);
+
     // Function to lerp between two angles
     double LerpAngle(double startAngle, double endAngle, float t);
 }
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "Rig.h"
+#include "TileRenderer.h"
+#include "AntiAliasedRenderer.h"
+
+#include <cstdint>
+#include <vector>
+
+class TaskScheduler;
+
+/// <summary>
+/// Persistent canvas for the editor viewport, redrawn by dirty rectangles.
+/// Every frame the viewport submits its layers (e.g. a figure's onion skin, then its pose) as stick shapes
+/// in draw order. A layer whose shapes changed damages its previous and current bounds, and only the damaged
+/// rectangles are cleared and rasterized again, with every layer overlapping them, so redrawing costs what
+/// moved rather than the whole scene. Layers carry a revision, so an unchanged one isn't even collected.
+/// Presenting copies only the redrawn rectangles to the screen, plus whatever the caller drew over since.
+/// </summary>
+class ViewportCanvas {
+public:
+    ViewportCanvas(int width, int height);
+
+    void SetBackground(const olc::Pixel& color);
+    void SetAntiAliased(bool antiAliased);
+    bool IsAntiAliased() const { return m_antiAliased; }
+
+    /// <summary>
+    /// Damages the whole canvas, e.g. when something outside the layers changed
+    /// </summary>
+    void Invalidate() { m_invalid = true; }
+
+    /// <summary>
+    /// Starts submitting the layers of a new frame
+    /// </summary>
+    void BeginFrame();
+
+    /// <summary>
+    /// Adds a layer on top of the previous ones and returns its shape list to fill, in canvas coordinates.
+    /// The key identifies the layer from one frame to the next, the revision changes whenever its shapes may.
+    /// </summary>
+    /// <returns>nullptr if last frame had the same layer at the same revision, its shapes are kept</returns>
+    std::vector<StickShape>* AddLayer(uint64_t key, uint64_t revision);
+
+    /// <summary>
+    /// Compares the layers with the last frame's and redraws the damaged rectangles
+    /// </summary>
+    void EndFrame(TaskScheduler& scheduler);
+
+    /// <summary>
+    /// Marks a rectangle of the presented canvas (in canvas coordinates) as drawn over, so the next Present copies it again
+    /// </summary>
+    void MarkOverdrawn(const olc::vi2d& position, const olc::vi2d& size);
+
+    /// <summary>
+    /// Copies the canvas into a sprite with its top left corner at position, clipped to the sprite.
+    /// Only what was redrawn or marked overdrawn since the last call is copied, everything when the position moved.
+    /// </summary>
+    void Present(olc::Sprite& target, const olc::vi2d& position);
+
+    const olc::Sprite& GetSprite() const { return m_canvas; }
+
+    /// <summary>
+    /// Pixels redrawn by the last EndFrame
+    /// </summary>
+    size_t RedrawnPixels() const { return m_redrawnPixels; }
+
+    /// <summary>
+    /// Pixels copied by the last Present
+    /// </summary>
+    size_t PresentedPixels() const { return m_presentedPixels; }
+
+private:
+    // inclusive, empty when left > right
+    struct Bounds {
+        int left, top, right, bottom;
+
+        bool IsEmpty() const { return left > right || top > bottom; }
+        bool Overlaps(const Bounds& other) const;
+        void Merge(const Bounds& other);
+    };
+
+    struct Layer {
+        uint64_t key;
+        uint64_t revision;
+        bool kept;
+        std::vector<StickShape> shapes;
+        Bounds bounds;
+    };
+
+    static Bounds ShapeBounds(const std::vector<StickShape>& shapes);
+
+    // adds the clipped rectangle to a list, merged with the ones it overlaps
+    void Damage(std::vector<Bounds>& rects, const Bounds& bounds) const;
+    void Redraw(TaskScheduler& scheduler, const Bounds& bounds);
+
+    olc::Sprite m_canvas;
+    olc::Pixel m_background{ olc::WHITE };
+    bool m_antiAliased{ false };
+    bool m_invalid{ true };
+
+    // this frame's and last frame's layers, swapped every frame so the shape lists keep their storage
+    std::vector<Layer> m_layers, m_previous;
+    size_t m_layerCount{ 0 }, m_previousCount{ 0 };
+
+    std::vector<Bounds> m_damage;
+    size_t m_redrawnPixels{ 0 };
+
+    // redrawn or drawn over since the last Present
+    std::vector<Bounds> m_unpresented;
+    olc::vi2d m_presentedAt{ 0, 0 };
+    bool m_presented{ false };
+    size_t m_presentedPixels{ 0 };
+
+    TileRenderer m_tiles;
+    AntiAliasedRenderer m_smooth;
+};
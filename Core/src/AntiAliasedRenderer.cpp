@@ -0,0 +1,109 @@
+#include "AntiAliasedRenderer.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void AntiAliasedRenderer::Clear() {
+    m_primitives.clear();
+}
+
+void AntiAliasedRenderer::AddCapsule(const olc::vf2d& a, const olc::vf2d& b, float radius, const olc::Pixel& color) {
+    if (radius <= 0.0f || color.a == 0) return;
+
+    // coverage fades out over half a pixel past the radius
+    const float reach = radius + 0.5f;
+    Primitive primitive{
+        utils::Capsule(olc::vd2d(a), olc::vd2d(b), reach),
+        utils::SdfCapsule(a, b, radius),
+        int(std::ceil(std::min(a.x, b.x) - reach)),
+        int(std::floor(std::max(a.x, b.x) + reach)),
+        color
+    };
+    m_primitives.push_back(primitive);
+}
+
+void AntiAliasedRenderer::AddStickShape(
+    const olc::vf2d& start, const olc::vf2d& tip,
+    bool isCircle,
+    const olc::Pixel& color,
+    float scale,
+    bool selected
+) {
+    // same sizes as DrawStickShape and DrawThickLine in Stick.cpp: a width 3 line covers 3.5 pixels
+    // around the segment, and FillCircle of radius r about r + 0.5
+    if (!isCircle) {
+        if (selected) {
+            AddCapsule(start, start + tip, 4.5f * scale, olc::BLUE);
+        }
+        AddCapsule(start, start + tip, 3.5f * scale, color);
+    }
+    else {
+        const olc::vf2d center = start + tip * 0.5f;
+        const float radius = tip.mag() * 0.5f + 0.5f * scale;
+        if (selected) {
+            AddCircle(center, radius + scale, olc::BLUE);
+        }
+        AddCircle(center, radius, color);
+    }
+}
+
+void AntiAliasedRenderer::Render(TaskScheduler& scheduler, olc::Sprite& target) {
+    Render(scheduler, target.GetData(), target.width, target.height, size_t(target.width));
+}
+
+void AntiAliasedRenderer::Render(TaskScheduler& scheduler, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) {
+    if (!pixels || width <= 0 || height <= 0 || m_primitives.empty()) return;
+
+    m_tilesX = (width + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (height + m_tileSize - 1) / m_tileSize;
+    m_bins.resize(size_t(m_tilesX) * m_tilesY);
+    for (auto& bin : m_bins) bin.clear();
+
+    // binning by bounds, serially so every bin stays in submission order
+    for (uint32_t i = 0; i < uint32_t(m_primitives.size()); i++) {
+        const Primitive& p = m_primitives[i];
+        const int left = p.left - origin.x, right = p.right - origin.x;
+        const int top = p.reach.top - origin.y, bottom = p.reach.bottom - origin.y;
+        if (right < 0 || bottom < 0 || left >= width || top >= height) continue;
+
+        const int tx0 = std::max(left, 0) / m_tileSize;
+        const int ty0 = std::max(top, 0) / m_tileSize;
+        const int tx1 = std::min(right, width - 1) / m_tileSize;
+        const int ty1 = std::min(bottom, height - 1) / m_tileSize;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                m_bins[size_t(ty) * m_tilesX + tx].push_back(i);
+            }
+        }
+    }
+
+    // tiles don't share pixels, so they can be blended in any order on any thread
+    scheduler.ParallelFor(0, m_bins.size(), [&](size_t tile) {
+        RenderTile(int(tile % m_tilesX), int(tile / m_tilesX), pixels, width, height, pitch, origin);
+    });
+}
+
+void AntiAliasedRenderer::RenderTile(int tileX, int tileY, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) const {
+    // in the primitives' coordinates
+    const int left = origin.x + tileX * m_tileSize;
+    const int top = origin.y + tileY * m_tileSize;
+    const int right = origin.x + std::min((tileX + 1) * m_tileSize, width) - 1;
+    const int bottom = origin.y + std::min((tileY + 1) * m_tileSize, height) - 1;
+
+    for (uint32_t i : m_bins[size_t(tileY) * m_tilesX + tileX]) {
+        const Primitive& p = m_primitives[i];
+        const int y0 = std::max(p.reach.top, top);
+        const int y1 = std::min(p.reach.bottom, bottom);
+
+        int x0, x1;
+        for (int y = y0; y <= y1; y++) {
+            if (!p.reach.Span(y, x0, x1)) continue;
+            x0 = std::max(x0, left);
+            x1 = std::min(x1, right);
+            if (x0 > x1) continue;
+            olc::Pixel* span = pixels + size_t(y - origin.y) * pitch + (x0 - origin.x);
+            utils::BlendCapsuleSpan(span, y, x0, x1, p.shape, p.color);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "FixedTrig.h"
+#include "Utility.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+
+namespace utils {
+    constexpr int32_t QuarterTurn = AngleUnitsPerTurn / 4;
+
+    // pi/2 in Q30
+    constexpr int64_t HalfPiQ30 = 1686629713;
+
+    static std::atomic<bool> gFixedPointMode{ false };
+
+    // sin(x) for x in [0, pi/2] by its Taylor series, entirely in Q30 integers so the
+    // table comes out the same on every build. The x^17 term is below one Q30 step.
+    static int32_t TaylorSinQ30(int64_t x) {
+        const int64_t x2 = (x * x) >> 30;
+        int64_t term = x, sum = x;
+        for (int64_t n = 2; n <= 16; n += 2) {
+            term = -(term * x2 >> 30) / (n * (n + 1));
+            sum += term;
+        }
+        return int32_t(sum);
+    }
+
+    static std::array<int32_t, QuarterTurn + 1> BuildSineTable() {
+        std::array<int32_t, QuarterTurn + 1> table{};
+        for (int32_t i = 0; i <= QuarterTurn; i++) {
+            table[i] = TaylorSinQ30(HalfPiQ30 * i / QuarterTurn);
+        }
+        return table;
+    }
+
+    static const std::array<int32_t, QuarterTurn + 1> gSineTable = BuildSineTable();
+
+    bool GetFixedPointMode() {
+        return gFixedPointMode.load(std::memory_order_relaxed);
+    }
+
+    void SetFixedPointMode(bool enabled) {
+        gFixedPointMode.store(enabled, std::memory_order_relaxed);
+    }
+
+    // Rounds to nearest, ties to even (the default rounding mode). There is no add for the compiler
+    // to fuse with the caller's multiply (-ffp-contract=fast contracts across statements and inlined
+    // calls), so the result is the same on every build; and it's one conversion instruction, unlike llround.
+    static int32_t RoundToInt(double value) {
+        return int32_t(std::lrint(value));
+    }
+
+    int32_t ToAngleUnits(double radians) {
+        return RoundToInt(radians * (AngleUnitsPerTurn / (2.0 * Pi)));
+    }
+
+    int32_t ToFixedQ16(double value) {
+        return RoundToInt(value * (1 << 16));
+    }
+
+    int32_t SinQ30(int32_t units) {
+        const uint32_t u = uint32_t(units) & (AngleUnitsPerTurn - 1);
+        const uint32_t r = u & (QuarterTurn - 1);
+        switch (u / QuarterTurn) {
+            case 0: return gSineTable[r];
+            case 1: return gSineTable[QuarterTurn - r];
+            case 2: return -gSineTable[r];
+            default: return -gSineTable[QuarterTurn - r];
+        }
+    }
+
+    int32_t CosQ30(int32_t units) {
+        return SinQ30(int32_t(uint32_t(units) + QuarterTurn));
+    }
+
+    void SinCosQ30(int32_t units, int32_t& sine, int32_t& cosine) {
+        // branchless quadrant fold, random angles would mispredict a switch half of the time
+        const uint32_t u = uint32_t(units) & (AngleUnitsPerTurn - 1);
+        const uint32_t r = u & (QuarterTurn - 1);
+        const uint32_t rs = (u & QuarterTurn) ? QuarterTurn - r : r;
+        const uint32_t rc = QuarterTurn - rs;
+        const int32_t negS = -int32_t((u >> 15) & 1);
+        const int32_t negC = -int32_t(((u + QuarterTurn) >> 15) & 1);
+        sine = (gSineTable[rs] ^ negS) - negS;
+        cosine = (gSineTable[rc] ^ negC) - negC;
+    }
+
+    int32_t AngleUnitsDelta(int32_t startAngle, int32_t endAngle) {
+        // same tie-break as LerpAngle: exactly half a turn goes forward
+        int32_t delta = int32_t(uint32_t(endAngle - startAngle) & (AngleUnitsPerTurn - 1));
+        if (delta > AngleUnitsPerTurn / 2) delta -= AngleUnitsPerTurn;
+        return delta;
+    }
+
+    int32_t LerpAngleUnits(int32_t startAngle, int32_t endAngle, int32_t t) {
+        return startAngle + int32_t(int64_t(AngleUnitsDelta(startAngle, endAngle)) * t / (1 << 16));
+    }
+}
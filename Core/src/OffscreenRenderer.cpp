@@ -0,0 +1,100 @@
+#include "OffscreenRenderer.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+OffscreenRenderer::OffscreenRenderer(TaskScheduler* scheduler, int tileSize)
+    : m_scheduler(scheduler), m_tiles(tileSize), m_smooth(tileSize) {
+    if (!m_scheduler) {
+        m_ownScheduler = std::make_unique<TaskScheduler>(0);
+        m_scheduler = m_ownScheduler.get();
+    }
+}
+
+OffscreenRenderer::~OffscreenRenderer() = default;
+
+void OffscreenRenderer::Render(const std::vector<std::shared_ptr<Figure>>& figures, olc::Sprite& target) {
+    Render(figures, target.GetData(), target.width, target.height, size_t(target.width));
+}
+
+void OffscreenRenderer::Render(
+    const std::vector<std::shared_ptr<Figure>>& figures,
+    olc::Pixel* pixels, int width, int height, size_t pitch
+) {
+    if (!pixels || width <= 0 || height <= 0) return;
+
+    for (int y = 0; y < height; y++) {
+        olc::Pixel* row = pixels + size_t(y) * pitch;
+        std::fill(row, row + width, m_background);
+    }
+
+    m_scheduler->ParallelFor(0, figures.size(), [&](size_t i) {
+        figures[i]->UpdateTransforms();
+    });
+
+    if (m_antiAliased) {
+        m_smooth.Clear();
+        for (auto& fig : figures) {
+            fig->Draw(m_smooth, { 0.0f, 0.0f }, m_scale);
+        }
+        m_smooth.Render(*m_scheduler, pixels, width, height, pitch);
+        return;
+    }
+
+    m_tiles.Clear();
+    for (auto& fig : figures) {
+        fig->Draw(m_tiles);
+    }
+    m_tiles.Render(*m_scheduler, pixels, width, height, pitch);
+}
+
+void OffscreenRenderer::RenderAnimation(
+    const std::vector<std::shared_ptr<Figure>>& figures,
+    olc::Sprite& target,
+    int frameCount,
+    const std::function<void(int frame)>& onFrame
+) {
+    // rendering poses the live figures, keep their pose (unkeyed edits included)
+    std::vector<Pose> livePoses(figures.size());
+    for (size_t i = 0; i < figures.size(); i++) {
+        figures[i]->CapturePose(livePoses[i]);
+    }
+
+    // keyframes are evaluated a chunk of frames at a time per figure, starting from the live pose
+    constexpr int ChunkFrames = 64;
+    std::vector<std::vector<StickPose>> chunks(figures.size());
+    std::vector<Pose> chunkStart = livePoses;
+
+    auto restore = [&] {
+        for (size_t i = 0; i < figures.size(); i++) {
+            figures[i]->ApplyPose(livePoses[i]);
+            figures[i]->InvalidatePose();
+        }
+    };
+
+    try {
+        for (int chunkFirst = 0; chunkFirst < frameCount; chunkFirst += ChunkFrames) {
+            const int chunkLast = std::min(chunkFirst + ChunkFrames, frameCount);
+
+            m_scheduler->ParallelFor(0, figures.size(), [&](size_t i) {
+                const size_t size = chunkStart[i].Size();
+                chunks[i].resize(size * (chunkLast - chunkFirst));
+                figures[i]->EvaluateRange(chunkFirst, chunkLast, chunkStart[i].sticks.data(), chunks[i].data());
+                std::copy_n(chunks[i].end() - size, size, chunkStart[i].sticks.begin());
+            });
+
+            for (int frame = chunkFirst; frame < chunkLast; frame++) {
+                for (size_t i = 0; i < figures.size(); i++) {
+                    figures[i]->ApplyPose(&chunks[i][chunkStart[i].Size() * (frame - chunkFirst)]);
+                }
+                Render(figures, target);
+                onFrame(frame);
+            }
+        }
+    }
+    catch (...) {
+        restore();
+        throw;
+    }
+    restore();
+}
@@ -0,0 +1,162 @@
+#include "PoseCache.h"
+#include "FixedTrig.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PoseCache::Update(const std::vector<std::shared_ptr<Figure>>& figures, int frameCount) {
+    frameCount = std::max(frameCount, 0);
+
+    bool layoutChanged = figures.size() != m_slots.size();
+    for (size_t i = 0; !layoutChanged && i < figures.size(); i++) {
+        Figure* fig = figures[i].get();
+        const Slot& slot = m_slots[i];
+        size_t size = fig->GetRig().Size();
+        layoutChanged = fig != slot.figure || fig->rigRevision != slot.rigRevision || size != slot.count;
+    }
+
+    if (layoutChanged) {
+        Rebuild(figures, frameCount);
+    }
+    else if (frameCount != m_frameCount) {
+        m_poses.resize(m_stride * frameCount);
+        if (frameCount > m_frameCount) {
+            // new frames continue from the last baked one
+            for (auto& slot : m_slots) {
+                slot.staleFirst = slot.staleFirst < slot.staleLast ? std::min(slot.staleFirst, m_frameCount) : m_frameCount;
+                slot.staleLast = frameCount;
+            }
+        }
+        m_frameCount = frameCount;
+    }
+
+    for (auto& slot : m_slots) {
+        // a hand-edited pose is what sticks hold outside their tracks, InvalidatePose marked every frame stale
+        if (slot.figure->restStale) {
+            slot.figure->CapturePose(&m_rest[slot.offset]);
+            slot.figure->restStale = false;
+        }
+
+        auto [first, last] = slot.figure->TakeStaleFrames();
+        if (first < last) {
+            if (slot.staleFirst < slot.staleLast) {
+                first = std::min(first, slot.staleFirst);
+                last = std::max(last, slot.staleLast);
+            }
+        }
+        else {
+            first = slot.staleFirst;
+            last = slot.staleLast;
+        }
+
+        first = std::max(first, 0);
+        last = std::min(last, m_frameCount);
+        if (first < last) {
+            Bake(slot, first, last);
+        }
+        slot.staleFirst = slot.staleLast = 0;
+    }
+}
+
+const StickPose* PoseCache::GetPose(const Figure& figure, int frame) const {
+    if (frame < 0 || frame >= m_frameCount) return nullptr;
+
+    auto it = m_slotIndex.find(&figure);
+    if (it == m_slotIndex.end()) return nullptr;
+
+    const Slot& slot = m_slots[it->second];
+    if (figure.rigDirty || figure.rigRevision != slot.rigRevision || figure.rig.Size() != slot.count) return nullptr;
+
+    return &m_poses[size_t(frame) * m_stride + slot.offset];
+}
+
+bool PoseCache::Apply(Figure& figure, int frame) const {
+    const StickPose* pose = GetPose(figure, frame);
+    if (!pose) return false;
+
+    if (figure.poseEvaluated && figure.evaluatedFrame == frame && figure.evaluatedRevision == figure.animationRevision) {
+        return true;
+    }
+
+    figure.ApplyPose(pose);
+    figure.poseEvaluated = true;
+    figure.evaluatedFrame = frame;
+    figure.evaluatedRevision = figure.animationRevision;
+    return true;
+}
+
+bool PoseCache::Apply(Figure& figure, float time) const {
+    const int frame = int(std::floor(time));
+    if (time == float(frame)) return Apply(figure, frame);
+
+    const StickPose* from = GetPose(figure, frame);
+    if (!from) return false;
+
+    // the last frame holds, same as the keyframes past the end of a track
+    const StickPose* to = GetPose(figure, frame + 1);
+    if (!to) to = from;
+
+    const float t = time - float(frame);
+    const bool fixedPoint = utils::GetFixedPointMode();
+    const int32_t fixedT = int32_t(std::lround(t * 65536.0));
+
+    Rig& rig = figure.GetRig();
+    for (size_t i = 0; i < rig.sticks.size(); i++) {
+        Stick* stick = rig.sticks[i];
+        if (fixedPoint) {
+            const int32_t units = utils::LerpAngleUnits(utils::ToAngleUnits(from[i].angle), utils::ToAngleUnits(to[i].angle), fixedT);
+            stick->angle = utils::FromAngleUnits(units);
+            stick->pos = olc::vi2d{
+                utils::LerpQ16(from[i].pos.x, to[i].pos.x, fixedT),
+                utils::LerpQ16(from[i].pos.y, to[i].pos.y, fixedT)
+            };
+        }
+        else {
+            stick->angle = utils::LerpAngle(from[i].angle, to[i].angle, t);
+            stick->pos = olc::vf2d{ from[i].pos }.lerp(olc::vf2d{ to[i].pos }, t);
+        }
+    }
+
+    // a sub-frame pose doesn't match any frame, the next Apply or Animate at a whole frame has to re-apply
+    figure.poseEvaluated = false;
+    return true;
+}
+
+void PoseCache::Clear() {
+    m_slots.clear();
+    m_slotIndex.clear();
+    m_rest.clear();
+    m_poses.clear();
+    m_stride = 0;
+    m_frameCount = 0;
+}
+
+void PoseCache::Rebuild(const std::vector<std::shared_ptr<Figure>>& figures, int frameCount) {
+    Clear();
+
+    for (auto& fig : figures) {
+        Rig& rig = fig->GetRig();
+        m_slotIndex[fig.get()] = m_slots.size();
+        m_slots.push_back(Slot{ fig.get(), fig->rigRevision, m_stride, rig.Size(), 0, frameCount });
+        m_stride += rig.Size();
+        fig->TakeStaleFrames();
+    }
+
+    m_rest.resize(m_stride);
+    for (auto& slot : m_slots) {
+        slot.figure->CapturePose(&m_rest[slot.offset]);
+        slot.figure->restStale = false;
+    }
+
+    m_frameCount = frameCount;
+    m_poses.resize(m_stride * frameCount);
+}
+
+void PoseCache::Bake(Slot& slot, int first, int last) {
+    // continue from the frame before, so held (unkeyed) poses match sequential playback
+    const StickPose* start = first == 0
+        ? &m_rest[slot.offset]
+        : &m_poses[size_t(first - 1) * m_stride + slot.offset];
+
+    slot.figure->EvaluateRange(first, last, start, &m_poses[size_t(first) * m_stride + slot.offset], m_stride);
+}
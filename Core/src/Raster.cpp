@@ -0,0 +1,122 @@
+#include "Raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace utils {
+    Capsule::Capsule(const olc::vd2d& a, const olc::vd2d& b, float radius)
+        : ax(a.x), ay(a.y), bx(b.x), by(b.y),
+          radius(std::max(radius, 0.0f)),
+          dx(b.x - a.x), dy(b.y - a.y) {
+        lengthSq = dx * dx + dy * dy;
+        radiusSq = this->radius * this->radius;
+        reach = this->radius * std::sqrt(lengthSq);
+        top = int(std::ceil(std::min(ay, by) - this->radius));
+        bottom = int(std::floor(std::max(ay, by) + this->radius));
+
+        // body: 0 <= (x - ax) * dx + (y - ay) * dy <= length^2 and |(x - ax) * dy - (y - ay) * dx| <= radius * length.
+        // Solved for x, each edge is base + slope * y
+        hasBody = lengthSq > 0.0;
+        projFlat = dx == 0.0;
+        sideFlat = dy == 0.0;
+        if (!projFlat) {
+            double lo = ax + ay * dy / dx, hi = lo + lengthSq / dx;
+            if (dx < 0.0) std::swap(lo, hi);
+            projLoBase = lo;
+            projHiBase = hi;
+            projSlope = -dy / dx;
+        }
+        if (!sideFlat) {
+            double lo = ax - ay * dx / dy - reach / dy, hi = ax - ay * dx / dy + reach / dy;
+            if (dy < 0.0) std::swap(lo, hi);
+            sideLoBase = lo;
+            sideHiBase = hi;
+            sideSlope = dx / dy;
+        }
+    }
+
+    bool Capsule::Span(int y, int& x0, int& x1) const {
+        // the capsule is convex, so its row is the union of what the two caps and the body cover
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -lo;
+
+        auto cap = [&](double cx, double cy) {
+            const double ey = y - cy;
+            const double h2 = radiusSq - ey * ey;
+            if (h2 < 0.0) return;
+            const double h = std::sqrt(h2);
+            lo = std::min(lo, cx - h);
+            hi = std::max(hi, cx + h);
+        };
+        cap(ax, ay);
+        cap(bx, by);
+
+        if (hasBody) {
+            double bodyLo = -std::numeric_limits<double>::infinity();
+            double bodyHi = -bodyLo;
+            const double ey = y - ay;
+            bool inside = true;
+
+            if (projFlat) {
+                const double proj = ey * dy;
+                inside = proj >= 0.0 && proj <= lengthSq;
+            }
+            else {
+                bodyLo = projLoBase + projSlope * y;
+                bodyHi = projHiBase + projSlope * y;
+            }
+
+            if (sideFlat) {
+                inside = inside && std::abs(ey * dx) <= reach;
+            }
+            else {
+                bodyLo = std::max(bodyLo, sideLoBase + sideSlope * y);
+                bodyHi = std::min(bodyHi, sideHiBase + sideSlope * y);
+            }
+
+            if (inside && bodyLo <= bodyHi) {
+                lo = std::min(lo, bodyLo);
+                hi = std::max(hi, bodyHi);
+            }
+        }
+
+        if (lo > hi) return false;
+        x0 = int(std::ceil(lo));
+        x1 = int(std::floor(hi));
+        return x0 <= x1;
+    }
+
+    void FillSpan(olc::PixelGameEngine* pge, int y, int x0, int x1, const olc::Pixel& color) {
+        olc::Sprite* target = pge->GetDrawTarget();
+        if (!target || y < 0 || y >= target->height) return;
+
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, target->width - 1);
+        if (x0 > x1) return;
+
+        if (pge->GetPixelMode() == olc::Pixel::NORMAL) {
+            olc::Pixel* row = target->GetData() + size_t(y) * target->width;
+            std::fill(row + x0, row + x1 + 1, color);
+            return;
+        }
+
+        for (int x = x0; x <= x1; x++) {
+            pge->Draw(x, y, color);
+        }
+    }
+
+    void FillCapsule(olc::PixelGameEngine* pge, const olc::vi2d& a, const olc::vi2d& b, float radius, const olc::Pixel& color) {
+        olc::Sprite* target = pge->GetDrawTarget();
+        if (!target) return;
+
+        const Capsule capsule(a, b, radius);
+        const int top = std::max(capsule.top, 0);
+        const int bottom = std::min(capsule.bottom, target->height - 1);
+
+        int x0, x1;
+        for (int y = top; y <= bottom; y++) {
+            if (capsule.Span(y, x0, x1)) FillSpan(pge, y, x0, x1, color);
+        }
+    }
+}
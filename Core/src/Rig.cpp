@@ -0,0 +1,303 @@
+#include "Rig.h"
+#include "Stick.h"
+#include "SimdTrig.h"
+#include "FixedTrig.h"
+#include "TileRenderer.h"
+#include "AntiAliasedRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+void Rig::Compile(Stick* root) {
+    sticks.clear();
+
+    RigDefinition def;
+    if (root) {
+        std::map<const Stick*, int> indices;
+        std::vector<std::pair<Stick*, int>> stack{ { root, -1 } };
+        while (!stack.empty()) {
+            auto [stick, parentIndex] = stack.back();
+            stack.pop_back();
+
+            int index = int(sticks.size());
+            indices[stick] = index;
+
+            uint8_t f = 0;
+            if (stick->isCircle) f |= RigCircle;
+            if (stick->isVisible) f |= RigVisible;
+            if (stick->isDriver) f |= RigDriver;
+            if (stick->IsDriven()) f |= RigDriven;
+
+            sticks.push_back(stick);
+            def.parent.push_back(parentIndex);
+            def.length.push_back(stick->len);
+            def.color.push_back(stick->color);
+            def.drawOrder.push_back(stick->drawOrder);
+            def.flags.push_back(f);
+            def.driverInfluence.push_back(stick->driverInfluence);
+            def.driverAngleOffset.push_back(stick->driverAngleOffset * Pi / 180.0f);
+
+            // push in reverse so children come out in declaration order
+            for (auto it = stick->children.rbegin(); it != stick->children.rend(); ++it) {
+                stack.push_back({ it->get(), index });
+            }
+        }
+
+        for (auto stick : sticks) {
+            auto it = stick->IsDriven() ? indices.find(stick->driver) : indices.end();
+            def.driver.push_back(it != indices.end() ? it->second : -1);
+        }
+    }
+
+    const size_t count = sticks.size();
+
+    // a driver outside of this tree can't be evaluated here
+    for (size_t i = 0; i < count; i++) {
+        if (def.driver[i] == -1) def.flags[i] &= ~RigDriven;
+    }
+
+    // topological sort of the driver edges (Kahn). A driven stick only depends on
+    // its driver's local angle; world transforms already follow the parent-first order.
+    std::vector<std::vector<int>> driven(count);
+    for (size_t i = 0; i < count; i++) {
+        if (def.flags[i] & RigDriven) driven[def.driver[i]].push_back(int(i));
+    }
+
+    // appends a stick, then everything it drives directly or through other sticks
+    std::vector<bool> ordered(count, false);
+    auto order = [&](int first) {
+        size_t head = def.driveOrder.size();
+        ordered[first] = true;
+        def.driveOrder.push_back(first);
+        for (; head < def.driveOrder.size(); head++) {
+            for (int next : driven[def.driveOrder[head]]) {
+                if (ordered[next]) continue;
+                ordered[next] = true;
+                def.driveOrder.push_back(next);
+            }
+        }
+    };
+    for (size_t i = 0; i < count; i++) {
+        if (!(def.flags[i] & RigDriven)) order(int(i));
+    }
+
+    // What is left sits on a driver cycle or downstream of one. Loading and editing refuse links
+    // that close a cycle, so this is a last resort: one stick of each cycle loses its driver and
+    // keeps its own angle, in the tree as well so Stick::Angle can't recurse forever.
+    for (size_t i = 0; i < count; i++) {
+        if (ordered[i]) continue;
+
+        // walk up the drivers until one repeats, that one is on the cycle
+        std::vector<bool> seen(count, false);
+        int cut = int(i);
+        while (!seen[cut]) {
+            seen[cut] = true;
+            cut = def.driver[cut];
+        }
+
+        const int former = def.driver[cut];
+        def.flags[cut] &= ~RigDriven;
+        def.driver[cut] = -1;
+        sticks[cut]->driver = nullptr;
+        order(cut);
+
+        // the former driver stops being one unless another stick still follows it
+        if (std::none_of(sticks.begin(), sticks.end(), [&](const Stick* s) { return s->driver == sticks[former]; })) {
+            sticks[former]->isDriver = false;
+            def.flags[former] &= ~RigDriver;
+        }
+    }
+
+    def.drawList.resize(count);
+    for (size_t i = 0; i < count; i++) def.drawList[i] = int(i);
+    std::stable_sort(def.drawList.begin(), def.drawList.end(), [&def](int a, int b) {
+        return def.drawOrder[a] < def.drawOrder[b];
+    });
+
+    drawSticks.clear();
+    visibleDrawSticks.clear();
+    for (int i : def.drawList) {
+        drawSticks.push_back(sticks[i]);
+        if (def.flags[i] & RigVisible) visibleDrawSticks.push_back(sticks[i]);
+    }
+
+    definition = std::move(def);
+
+    pos.assign(count, olc::vi2d{ 0, 0 });
+    angle.assign(count, 0.0);
+    localAngle.assign(count, 0.0);
+    // sized by the first EvaluateFixed, most rigs never evaluate in fixed point
+    localUnits.clear();
+    worldUnits.clear();
+    worldPos.assign(count, olc::vi2d{ 0, 0 });
+    worldAngle.assign(count, 0.0);
+    tip.assign(count, olc::vi2d{ 0, 0 });
+}
+
+void Rig::Pull() {
+    for (size_t i = 0; i < sticks.size(); i++) {
+        pos[i] = sticks[i]->pos;
+        angle[i] = sticks[i]->angle;
+    }
+}
+
+void Rig::Pull(const StickPose* pose) {
+    for (size_t i = 0; i < sticks.size(); i++) {
+        pos[i] = pose[i].pos;
+        angle[i] = pose[i].angle;
+    }
+}
+
+void Rig::Evaluate() {
+    if (utils::GetFixedPointMode()) {
+        EvaluateFixed();
+        return;
+    }
+
+    const RigDefinition& def = definition;
+    const auto& parent = def.parent;
+    const auto& flags = def.flags;
+    const auto& driver = def.driver;
+    const size_t count = def.Size();
+
+    // angles don't depend on positions, so resolve them all first...
+    for (int i : def.driveOrder) {
+        localAngle[i] = (flags[i] & RigDriven)
+            ? localAngle[driver[i]] * def.driverInfluence[i] + def.driverAngleOffset[i]
+            : angle[i];
+    }
+    for (size_t i = 0; i < count; i++) {
+        const int p = parent[i];
+        worldAngle[i] = localAngle[i] + (p < 0 ? 0.0 : worldAngle[p]);
+    }
+
+    // ...then the tips in one batch...
+    utils::ComputeTips(worldAngle.data(), def.length.data(), tip.data(), count);
+
+    // ...and finally chain the positions
+    for (size_t i = 0; i < count; i++) {
+        const int p = parent[i];
+        worldPos[i] = p < 0 ? pos[i] : pos[i] + (worldPos[p] + tip[p]);
+    }
+}
+
+void Rig::EvaluateFixed() {
+    const RigDefinition& def = definition;
+    const auto& parent = def.parent;
+    const size_t count = def.Size();
+    localUnits.resize(count);
+    worldUnits.resize(count);
+
+    for (int i : def.driveOrder) {
+        if (def.flags[i] & RigDriven) {
+            const int64_t influence = utils::ToFixedQ16(def.driverInfluence[i]);
+            localUnits[i] = int32_t(localUnits[def.driver[i]] * influence / (1 << 16))
+                + utils::ToAngleUnits(def.driverAngleOffset[i]);
+        }
+        else {
+            localUnits[i] = utils::ToAngleUnits(angle[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const int p = parent[i];
+        worldUnits[i] = localUnits[i] + (p < 0 ? 0 : worldUnits[p]);
+        worldAngle[i] = utils::FromAngleUnits(worldUnits[i]);
+
+        const int64_t len = def.length[i];
+        if (len <= 0) {
+            tip[i] = olc::vi2d{ 0, 0 };
+            continue;
+        }
+        int32_t s, c;
+        utils::SinCosQ30(worldUnits[i], s, c);
+        tip[i] = olc::vi2d{ int(len * c / (1 << 30)), int(len * s / (1 << 30)) };
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const int p = parent[i];
+        worldPos[i] = p < 0 ? pos[i] : pos[i] + (worldPos[p] + tip[p]);
+    }
+}
+
+void Rig::Push() const {
+    for (size_t i = 0; i < sticks.size(); i++) {
+        Stick* stick = sticks[i];
+        stick->cachedWorldPos = worldPos[i];
+        stick->cachedWorldAngle = worldAngle[i];
+        stick->cachedTip = tip[i];
+    }
+}
+
+void Rig::Draw(olc::PixelGameEngine* pge, const olc::vi2d& offset, const olc::Pixel& colorOverride) const {
+    const RigDefinition& def = definition;
+    const auto& length = def.length;
+    const auto& flags = def.flags;
+
+    for (int i : def.drawList) {
+        if (length[i] <= 0) continue;
+        if (!(flags[i] & RigVisible) || (flags[i] & RigDriver)) continue;
+
+        olc::Pixel col = colorOverride.a > 0 ? colorOverride : def.color[i];
+        DrawStickShape(pge, worldPos[i] + offset, tip[i], length[i], flags[i] & RigCircle, col, false);
+    }
+}
+
+void Rig::Draw(TileRenderer& renderer, const olc::vi2d& offset, const olc::Pixel& colorOverride) const {
+    const RigDefinition& def = definition;
+    const auto& length = def.length;
+    const auto& flags = def.flags;
+
+    for (int i : def.drawList) {
+        if (length[i] <= 0) continue;
+        if (!(flags[i] & RigVisible) || (flags[i] & RigDriver)) continue;
+
+        olc::Pixel col = colorOverride.a > 0 ? colorOverride : def.color[i];
+        renderer.AddStickShape(worldPos[i] + offset, tip[i], length[i], flags[i] & RigCircle, col, false);
+    }
+}
+
+void Rig::CollectShapes(std::vector<StickShape>& out, bool subPixel, const olc::Pixel& colorOverride) const {
+    const RigDefinition& def = definition;
+    const auto& parent = def.parent;
+    const auto& length = def.length;
+    const auto& flags = def.flags;
+    const size_t count = def.Size();
+
+    // the same chain as Evaluate, without truncating the tips
+    std::vector<olc::vf2d> worldPosF, tipF;
+    if (subPixel) {
+        worldPosF.resize(count);
+        tipF.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const int p = parent[i];
+            tipF[i] = length[i] > 0
+                ? olc::vf2d{ float(std::cos(worldAngle[i]) * length[i]), float(std::sin(worldAngle[i]) * length[i]) }
+                : olc::vf2d{ 0.0f, 0.0f };
+            worldPosF[i] = p < 0 ? olc::vf2d(pos[i]) : olc::vf2d(pos[i]) + worldPosF[p] + tipF[p];
+        }
+    }
+
+    for (int i : def.drawList) {
+        if (length[i] <= 0) continue;
+        if (!(flags[i] & RigVisible) || (flags[i] & RigDriver)) continue;
+
+        out.push_back(StickShape{
+            subPixel ? worldPosF[i] : olc::vf2d(worldPos[i]),
+            subPixel ? tipF[i] : olc::vf2d(tip[i]),
+            length[i],
+            bool(flags[i] & RigCircle),
+            colorOverride.a > 0 ? colorOverride : def.color[i]
+        });
+    }
+}
+
+void Rig::Draw(AntiAliasedRenderer& renderer, const olc::vf2d& offset, float scale, const olc::Pixel& colorOverride) const {
+    std::vector<StickShape> shapes;
+    CollectShapes(shapes, true, colorOverride);
+
+    for (const StickShape& shape : shapes) {
+        renderer.AddStickShape(offset + shape.start * scale, shape.tip * scale, shape.isCircle, shape.color, scale, false);
+    }
+}
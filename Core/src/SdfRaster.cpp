@@ -0,0 +1,222 @@
+#include "SdfRaster.h"
+#include "SimdTrig.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STICKMATOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#define TARGET_SSE4
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+namespace utils {
+    SdfCapsule::SdfCapsule(const olc::vf2d& a, const olc::vf2d& b, float radius)
+        : ax(a.x), ay(a.y), dx(b.x - a.x), dy(b.y - a.y), radius(std::max(radius, 0.0f)) {
+        const float lengthSq = dx * dx + dy * dy;
+        invLengthSq = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;
+    }
+
+    // Every path below does the same float operations in the same order, so without FMA contraction they agree to the bit:
+    // t = clamp(((x - ax) * dx + (y - ay) * dy) * invLengthSq, 0, 1), the closest point of the segment,
+    // coverage = clamp(radius + 0.5 - |(x - ax, y - ay) - t * (dx, dy)|, 0, 1),
+    // weight = int(coverage * alpha * 256 / 255 + 0.5) in [0, 256],
+    // channel = (dst * (256 - weight) + src * weight) >> 8
+
+    static void BlendCapsuleSpanScalar(olc::Pixel* span, int y, int x0, int x1, const SdfCapsule& c, const olc::Pixel& color, float alphaScale) {
+        const float py = float(y) - c.ay;
+        const float pyDy = py * c.dy;
+        const float edge = c.radius + 0.5f;
+
+        for (int x = x0; x <= x1; x++) {
+            const float px = float(x) - c.ax;
+            const float t = std::min(std::max((px * c.dx + pyDy) * c.invLengthSq, 0.0f), 1.0f);
+            const float ex = px - t * c.dx;
+            const float ey = py - t * c.dy;
+            const float coverage = std::min(std::max(edge - std::sqrt(ex * ex + ey * ey), 0.0f), 1.0f);
+            const uint32_t weight = uint32_t(coverage * alphaScale + 0.5f);
+            if (weight == 0) continue;
+
+            olc::Pixel& dst = span[x - x0];
+            const uint32_t keep = 256 - weight;
+            dst.r = uint8_t((dst.r * keep + color.r * weight) >> 8);
+            dst.g = uint8_t((dst.g * keep + color.g * weight) >> 8);
+            dst.b = uint8_t((dst.b * keep + color.b * weight) >> 8);
+            dst.a = uint8_t((dst.a * keep + color.a * weight) >> 8);
+        }
+    }
+
+#ifdef STICKMATOR_X86
+    TARGET_AVX2
+    static void BlendCapsuleSpanAVX2(olc::Pixel* span, int y, int x0, int x1, const SdfCapsule& c, const olc::Pixel& color, float alphaScale) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 ax = _mm256_set1_ps(c.ax);
+        const __m256 dx = _mm256_set1_ps(c.dx);
+        const __m256 dy = _mm256_set1_ps(c.dy);
+        const __m256 invLengthSq = _mm256_set1_ps(c.invLengthSq);
+        const __m256 edge = _mm256_set1_ps(c.radius + 0.5f);
+        const __m256 alpha = _mm256_set1_ps(alphaScale);
+        const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+        const float py = float(y) - c.ay;
+        const __m256 pyV = _mm256_set1_ps(py);
+        const __m256 pyDy = _mm256_set1_ps(py * c.dy);
+
+        uint32_t packed;
+        std::memcpy(&packed, &color, sizeof(packed));
+        const __m256i src = _mm256_set1_epi32(int(packed));
+        const __m256i src16 = _mm256_unpacklo_epi8(src, _mm256_setzero_si256());
+        const __m256i full = _mm256_set1_epi32(256);
+        const __m256i full16 = _mm256_set1_epi16(256);
+
+        alignas(32) olc::Pixel tail[8];
+
+        for (int x = x0; x <= x1; x += 8) {
+            const int n = std::min(8, x1 - x + 1);
+
+            const __m256 px = _mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(float(x)), lanes), ax);
+            __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(px, dx), pyDy), invLengthSq);
+            t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+            const __m256 ex = _mm256_sub_ps(px, _mm256_mul_ps(t, dx));
+            const __m256 ey = _mm256_sub_ps(pyV, _mm256_mul_ps(t, dy));
+            const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)));
+            const __m256 coverage = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(edge, dist), zero), one);
+            const __m256i weight = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(coverage, alpha), half));
+
+            const int none = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(weight, _mm256_setzero_si256())));
+            if (none == 0xFF) continue;
+
+            olc::Pixel* out = span + (x - x0);
+            if (n < 8) {
+                std::copy_n(out, n, tail);
+                out = tail;
+            }
+
+            const int opaque = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(weight, full)));
+            if (opaque == 0xFF) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), src);
+            }
+            else {
+                // weights as 16 bit channels, lined up with the unpacked pixels: 0 1 | 4 5 low, 2 3 | 6 7 high
+                const __m256i weight2 = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+                const __m256i weightLo = _mm256_unpacklo_epi32(weight2, weight2);
+                const __m256i weightHi = _mm256_unpackhi_epi32(weight2, weight2);
+
+                const __m256i dst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out));
+                const __m256i dstLo = _mm256_unpacklo_epi8(dst, _mm256_setzero_si256());
+                const __m256i dstHi = _mm256_unpackhi_epi8(dst, _mm256_setzero_si256());
+
+                const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(
+                    _mm256_mullo_epi16(dstLo, _mm256_sub_epi16(full16, weightLo)),
+                    _mm256_mullo_epi16(src16, weightLo)
+                ), 8);
+                const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(
+                    _mm256_mullo_epi16(dstHi, _mm256_sub_epi16(full16, weightHi)),
+                    _mm256_mullo_epi16(src16, weightHi)
+                ), 8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_packus_epi16(lo, hi));
+            }
+
+            if (n < 8) std::copy_n(tail, n, span + (x - x0));
+        }
+    }
+
+    TARGET_SSE4
+    static void BlendCapsuleSpanSSE4(olc::Pixel* span, int y, int x0, int x1, const SdfCapsule& c, const olc::Pixel& color, float alphaScale) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 ax = _mm_set1_ps(c.ax);
+        const __m128 dx = _mm_set1_ps(c.dx);
+        const __m128 dy = _mm_set1_ps(c.dy);
+        const __m128 invLengthSq = _mm_set1_ps(c.invLengthSq);
+        const __m128 edge = _mm_set1_ps(c.radius + 0.5f);
+        const __m128 alpha = _mm_set1_ps(alphaScale);
+        const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+        const float py = float(y) - c.ay;
+        const __m128 pyV = _mm_set1_ps(py);
+        const __m128 pyDy = _mm_set1_ps(py * c.dy);
+
+        uint32_t packed;
+        std::memcpy(&packed, &color, sizeof(packed));
+        const __m128i src = _mm_set1_epi32(int(packed));
+        const __m128i src16 = _mm_unpacklo_epi8(src, _mm_setzero_si128());
+        const __m128i full = _mm_set1_epi32(256);
+        const __m128i full16 = _mm_set1_epi16(256);
+
+        alignas(16) olc::Pixel tail[4];
+
+        for (int x = x0; x <= x1; x += 4) {
+            const int n = std::min(4, x1 - x + 1);
+
+            const __m128 px = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(float(x)), lanes), ax);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(px, dx), pyDy), invLengthSq);
+            t = _mm_min_ps(_mm_max_ps(t, zero), one);
+            const __m128 ex = _mm_sub_ps(px, _mm_mul_ps(t, dx));
+            const __m128 ey = _mm_sub_ps(pyV, _mm_mul_ps(t, dy));
+            const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+            const __m128 coverage = _mm_min_ps(_mm_max_ps(_mm_sub_ps(edge, dist), zero), one);
+            const __m128i weight = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, alpha), half));
+
+            const int none = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(weight, _mm_setzero_si128())));
+            if (none == 0xF) continue;
+
+            olc::Pixel* out = span + (x - x0);
+            if (n < 4) {
+                std::copy_n(out, n, tail);
+                out = tail;
+            }
+
+            const int opaque = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(weight, full)));
+            if (opaque == 0xF) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), src);
+            }
+            else {
+                const __m128i weight2 = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+                const __m128i weightLo = _mm_unpacklo_epi32(weight2, weight2);
+                const __m128i weightHi = _mm_unpackhi_epi32(weight2, weight2);
+
+                const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out));
+                const __m128i dstLo = _mm_unpacklo_epi8(dst, _mm_setzero_si128());
+                const __m128i dstHi = _mm_unpackhi_epi8(dst, _mm_setzero_si128());
+
+                const __m128i lo = _mm_srli_epi16(_mm_add_epi16(
+                    _mm_mullo_epi16(dstLo, _mm_sub_epi16(full16, weightLo)),
+                    _mm_mullo_epi16(src16, weightLo)
+                ), 8);
+                const __m128i hi = _mm_srli_epi16(_mm_add_epi16(
+                    _mm_mullo_epi16(dstHi, _mm_sub_epi16(full16, weightHi)),
+                    _mm_mullo_epi16(src16, weightHi)
+                ), 8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+            }
+
+            if (n < 4) std::copy_n(tail, n, span + (x - x0));
+        }
+    }
+#endif
+
+    void BlendCapsuleSpan(olc::Pixel* span, int y, int x0, int x1, const SdfCapsule& capsule, const olc::Pixel& color) {
+        if (x0 > x1 || color.a == 0) return;
+        const float alphaScale = float(color.a) * (256.0f / 255.0f);
+
+        switch (GetSimdLevel()) {
+#ifdef STICKMATOR_X86
+            case SimdLevel::AVX2: BlendCapsuleSpanAVX2(span, y, x0, x1, capsule, color, alphaScale); break;
+            case SimdLevel::SSE4: BlendCapsuleSpanSSE4(span, y, x0, x1, capsule, color, alphaScale); break;
+#endif
+            default: BlendCapsuleSpanScalar(span, y, x0, x1, capsule, color, alphaScale); break;
+        }
+    }
+}
@@ -0,0 +1,297 @@
+#include "SimdTrig.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STICKMATOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#define TARGET_SSE4
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+namespace utils {
+    // Cody-Waite split of pi/2 (fdlibm), exact products for small quadrant counts
+    constexpr double TwoOverPi = 6.36619772367581382433e-01;
+    constexpr double PiO2_1 = 1.57079632673412561417e+00;
+    constexpr double PiO2_2 = 6.07710050630396597660e-11;
+    constexpr double PiO2_3 = 2.02226624871116645580e-21;
+
+    // minimax polynomials on [-pi/4, pi/4] (fdlibm __kernel_sin / __kernel_cos)
+    constexpr double S1 = -1.66666666666666324348e-01;
+    constexpr double S2 = 8.33333333332248946124e-03;
+    constexpr double S3 = -1.98412698298579493134e-04;
+    constexpr double S4 = 2.75573137070700676789e-06;
+    constexpr double S5 = -2.50507602534068634195e-08;
+    constexpr double S6 = 1.58969099521155010221e-10;
+
+    constexpr double C1 = 4.16666666666666019037e-02;
+    constexpr double C2 = -1.38888888888741095749e-03;
+    constexpr double C3 = 2.48015872894767294178e-05;
+    constexpr double C4 = -2.75573143513906633035e-07;
+    constexpr double C5 = 2.08757232129817482790e-09;
+    constexpr double C6 = -1.13596475577881948265e-11;
+
+    // past this the reduction above loses precision, so we hand over to libm
+    constexpr double MaxReducedAngle = 1.0e5;
+
+    // polynomial results this close to an integer could truncate differently than libm
+    constexpr double TruncationGuard = 1.0e-9;
+
+    static olc::vi2d ScalarTip(double angle, int len) {
+        if (len <= 0) return olc::vi2d{ 0, 0 };
+        double c = std::cos(angle) * len;
+        double s = std::sin(angle) * len;
+        return olc::vd2d{ c, s };
+    }
+
+    // Turns the vectorized products into integer tips, redoing the unsafe lanes in scalar
+    static void FinishTips(
+        const double* angles, const int* lengths,
+        const double* cx, const double* sy, const bool* unsafe,
+        olc::vi2d* tips, size_t count
+    ) {
+        for (size_t i = 0; i < count; i++) {
+            if (lengths[i] <= 0) {
+                tips[i] = olc::vi2d{ 0, 0 };
+            }
+            else if (unsafe[i] || std::abs(angles[i]) > MaxReducedAngle) {
+                tips[i] = ScalarTip(angles[i], lengths[i]);
+            }
+            else {
+                tips[i] = olc::vi2d{ int(cx[i]), int(sy[i]) };
+            }
+        }
+    }
+
+    static void ComputeTipsScalar(const double* angles, const int* lengths, olc::vi2d* tips, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            tips[i] = ScalarTip(angles[i], lengths[i]);
+        }
+    }
+
+#ifdef STICKMATOR_X86
+    TARGET_AVX2
+    static void ComputeTipsAVX2(const double* angles, const int* lengths, olc::vi2d* tips, size_t count) {
+        constexpr size_t Block = 64;
+        alignas(32) double cx[Block];
+        alignas(32) double sy[Block];
+        bool unsafe[Block];
+
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d half = _mm256_set1_pd(0.5);
+        const __m256d two = _mm256_set1_pd(2.0);
+        const __m256d four = _mm256_set1_pd(4.0);
+        const __m256d signBit = _mm256_set1_pd(-0.0);
+        const __m256d guard = _mm256_set1_pd(TruncationGuard);
+
+        for (size_t base = 0; base < count; base += Block) {
+            const size_t n = std::min(Block, count - base);
+            const double* a = angles + base;
+            const int* l = lengths + base;
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d x = _mm256_loadu_pd(a + i);
+                __m256d len = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i)));
+
+                __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(TwoOverPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(PiO2_1)));
+                r = _mm256_sub_pd(r, _mm256_mul_pd(k, _mm256_set1_pd(PiO2_2)));
+                r = _mm256_sub_pd(r, _mm256_mul_pd(k, _mm256_set1_pd(PiO2_3)));
+
+                __m256d z = _mm256_mul_pd(r, r);
+
+                __m256d ps = _mm256_set1_pd(S6);
+                ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S5));
+                ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S4));
+                ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S3));
+                ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S2));
+                ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S1));
+                __m256d sinR = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, z), ps));
+
+                __m256d pc = _mm256_set1_pd(C6);
+                pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C5));
+                pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C4));
+                pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C3));
+                pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C2));
+                pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C1));
+                __m256d cosR = _mm256_add_pd(
+                    _mm256_sub_pd(one, _mm256_mul_pd(half, z)),
+                    _mm256_mul_pd(_mm256_mul_pd(z, z), pc)
+                );
+
+                // quadrant q = k mod 4, kept in the double domain
+                __m256d q = _mm256_sub_pd(k, _mm256_mul_pd(four, _mm256_floor_pd(_mm256_mul_pd(k, _mm256_set1_pd(0.25)))));
+                __m256d odd = _mm256_cmp_pd(_mm256_sub_pd(q, _mm256_mul_pd(two, _mm256_floor_pd(_mm256_mul_pd(q, half)))), one, _CMP_EQ_OQ);
+                __m256d negSin = _mm256_cmp_pd(q, two, _CMP_GE_OQ);
+                __m256d negCos = _mm256_and_pd(_mm256_cmp_pd(q, one, _CMP_GE_OQ), _mm256_cmp_pd(q, two, _CMP_LE_OQ));
+
+                __m256d s = _mm256_blendv_pd(sinR, cosR, odd);
+                __m256d c = _mm256_blendv_pd(cosR, sinR, odd);
+                s = _mm256_xor_pd(s, _mm256_and_pd(negSin, signBit));
+                c = _mm256_xor_pd(c, _mm256_and_pd(negCos, signBit));
+
+                __m256d px = _mm256_mul_pd(c, len);
+                __m256d py = _mm256_mul_pd(s, len);
+                _mm256_store_pd(cx + i, px);
+                _mm256_store_pd(sy + i, py);
+
+                __m256d fx = _mm256_andnot_pd(signBit, _mm256_sub_pd(px, _mm256_round_pd(px, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)));
+                __m256d fy = _mm256_andnot_pd(signBit, _mm256_sub_pd(py, _mm256_round_pd(py, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)));
+                int mask = _mm256_movemask_pd(_mm256_or_pd(
+                    _mm256_cmp_pd(fx, guard, _CMP_LT_OQ),
+                    _mm256_cmp_pd(fy, guard, _CMP_LT_OQ)
+                ));
+                for (int j = 0; j < 4; j++) unsafe[i + j] = (mask >> j) & 1;
+            }
+
+            for (; i < n; i++) {
+                unsafe[i] = true;
+            }
+
+            FinishTips(a, l, cx, sy, unsafe, tips + base, n);
+        }
+    }
+
+    TARGET_SSE4
+    static void ComputeTipsSSE4(const double* angles, const int* lengths, olc::vi2d* tips, size_t count) {
+        constexpr size_t Block = 64;
+        alignas(16) double cx[Block];
+        alignas(16) double sy[Block];
+        bool unsafe[Block];
+
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d half = _mm_set1_pd(0.5);
+        const __m128d two = _mm_set1_pd(2.0);
+        const __m128d four = _mm_set1_pd(4.0);
+        const __m128d signBit = _mm_set1_pd(-0.0);
+        const __m128d guard = _mm_set1_pd(TruncationGuard);
+
+        for (size_t base = 0; base < count; base += Block) {
+            const size_t n = std::min(Block, count - base);
+            const double* a = angles + base;
+            const int* l = lengths + base;
+
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                __m128d x = _mm_loadu_pd(a + i);
+                __m128d len = _mm_set_pd(double(l[i + 1]), double(l[i]));
+
+                __m128d k = _mm_round_pd(_mm_mul_pd(x, _mm_set1_pd(TwoOverPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                __m128d r = _mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(PiO2_1)));
+                r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(PiO2_2)));
+                r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(PiO2_3)));
+
+                __m128d z = _mm_mul_pd(r, r);
+
+                __m128d ps = _mm_set1_pd(S6);
+                ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S5));
+                ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S4));
+                ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S3));
+                ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S2));
+                ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S1));
+                __m128d sinR = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), ps));
+
+                __m128d pc = _mm_set1_pd(C6);
+                pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C5));
+                pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C4));
+                pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C3));
+                pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C2));
+                pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C1));
+                __m128d cosR = _mm_add_pd(
+                    _mm_sub_pd(one, _mm_mul_pd(half, z)),
+                    _mm_mul_pd(_mm_mul_pd(z, z), pc)
+                );
+
+                __m128d q = _mm_sub_pd(k, _mm_mul_pd(four, _mm_floor_pd(_mm_mul_pd(k, _mm_set1_pd(0.25)))));
+                __m128d odd = _mm_cmpeq_pd(_mm_sub_pd(q, _mm_mul_pd(two, _mm_floor_pd(_mm_mul_pd(q, half)))), one);
+                __m128d negSin = _mm_cmpge_pd(q, two);
+                __m128d negCos = _mm_and_pd(_mm_cmpge_pd(q, one), _mm_cmple_pd(q, two));
+
+                __m128d s = _mm_blendv_pd(sinR, cosR, odd);
+                __m128d c = _mm_blendv_pd(cosR, sinR, odd);
+                s = _mm_xor_pd(s, _mm_and_pd(negSin, signBit));
+                c = _mm_xor_pd(c, _mm_and_pd(negCos, signBit));
+
+                __m128d px = _mm_mul_pd(c, len);
+                __m128d py = _mm_mul_pd(s, len);
+                _mm_store_pd(cx + i, px);
+                _mm_store_pd(sy + i, py);
+
+                __m128d fx = _mm_andnot_pd(signBit, _mm_sub_pd(px, _mm_round_pd(px, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)));
+                __m128d fy = _mm_andnot_pd(signBit, _mm_sub_pd(py, _mm_round_pd(py, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)));
+                int mask = _mm_movemask_pd(_mm_or_pd(_mm_cmplt_pd(fx, guard), _mm_cmplt_pd(fy, guard)));
+                unsafe[i] = mask & 1;
+                unsafe[i + 1] = (mask >> 1) & 1;
+            }
+
+            for (; i < n; i++) {
+                unsafe[i] = true;
+            }
+
+            FinishTips(a, l, cx, sy, unsafe, tips + base, n);
+        }
+    }
+
+    static SimdLevel DetectSimdLevel() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        bool sse41 = false, avx = false, avx2 = false;
+        if (maxLeaf >= 1) {
+            __cpuid(info, 1);
+            sse41 = (info[2] & (1 << 19)) != 0;
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            avx = (info[2] & (1 << 28)) != 0 && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        }
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2 = avx && (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2) return SimdLevel::AVX2;
+        if (sse41) return SimdLevel::SSE4;
+        return SimdLevel::Scalar;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE4;
+        return SimdLevel::Scalar;
+#endif
+    }
+#else
+    static SimdLevel DetectSimdLevel() {
+        return SimdLevel::Scalar;
+    }
+#endif
+
+    static SimdLevel gSupportedLevel = DetectSimdLevel();
+    static SimdLevel gSimdLevel = gSupportedLevel;
+
+    SimdLevel GetSimdLevel() {
+        return gSimdLevel;
+    }
+
+    void SetSimdLevel(SimdLevel level) {
+        gSimdLevel = std::min(level, gSupportedLevel);
+    }
+
+    void ComputeTips(const double* angles, const int* lengths, olc::vi2d* tips, size_t count) {
+        switch (gSimdLevel) {
+#ifdef STICKMATOR_X86
+            case SimdLevel::AVX2: ComputeTipsAVX2(angles, lengths, tips, count); break;
+            case SimdLevel::SSE4: ComputeTipsSSE4(angles, lengths, tips, count); break;
+#endif
+            default: ComputeTipsScalar(angles, lengths, tips, count); break;
+        }
+    }
+}
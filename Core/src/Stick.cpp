@@ -1,15 +1,20 @@
 #include "Stick.h"
+#include "FixedTrig.h"
+#include "Raster.h"
 
 #include <functional>
 #include <algorithm>
 #include <fstream>
 #include <memory>
 #include <cmath>
+#include <limits>
 #include <map>
 
 #include "olcPGEX_TinyGUI.h"
 
 int Stick::gStickId = 100;
+std::atomic<uint64_t> Figure::gRigRevision{ 0 };
+std::atomic<uint64_t> Figure::gTransformRevision{ 0 };
 
 Stick& Stick::AddChild(int len, double angle, MotionType motionType, bool isCircle) {
     Stick* stick = new Stick();
@@ -19,8 +24,14 @@ Stick& Stick::AddChild(int len, double angle, MotionType motionType, bool isCirc
     stick->len = len;
     stick->motionType = motionType;
     stick->isCircle = isCircle;
+    stick->figure = figure;
     stick->parent = this;
     children.push_back(std::unique_ptr<Stick>(stick));
+    stick->UpdateTransforms();
+    if (figure) {
+        figure->IndexSticks(stick);
+        figure->Invalidate();
+    }
     return *children.back().get();
 }
 
@@ -29,7 +40,14 @@ void Stick::RemoveChild(Stick* stick) {
 		return a.get() == stick;
 	});
 	if (stkPos != children.end()) {
+        if (figure) {
+            for (auto removed : stick->GetSticksRecursive()) {
+                for (auto& kf : removed->animation) figure->KeyRemoved(kf.frame);
+            }
+            figure->UnindexSticks(stick);
+        }
 		children.erase(stkPos);
+        if (figure) figure->Invalidate();
 	}
 }
 
@@ -53,18 +71,11 @@ Stick* Stick::GetRoot() {
 }
 
 olc::vi2d Stick::Tip() const {
-    if (len <= 0) return olc::vi2d{ 0, 0 };
-    double c = std::cos(WorldAngle()) * len;
-    double s = std::sin(WorldAngle()) * len;
-    return olc::vd2d{ c, s };
+    return cachedTip;
 }
 
 olc::vi2d Stick::WorldPos() const {
-    olc::vi2d parentPos = olc::vi2d{ 0, 0 };
-    if (parent) {
-        parentPos = parent->WorldPos() + parent->Tip();
-    }
-    return pos + parentPos;
+    return cachedWorldPos;
 }
 
 void Stick::SetWorldPos(olc::vi2d newPos) {
@@ -73,20 +84,31 @@ void Stick::SetWorldPos(olc::vi2d newPos) {
         parentPos = parent->WorldPos() + parent->Tip();
     }
     pos = newPos - parentPos;
+    UpdateTransforms();
 }
 
 double Stick::Angle() const {
     if (!IsDriven()) return angle;
     float offsetRadians = driverAngleOffset * Pi / 180.0f;
-    return driver->angle * driverInfluence + offsetRadians;
+    return driver->Angle() * driverInfluence + offsetRadians;
 }
 
-double Stick::WorldAngle() const {
-    double parentAngle = 0.0f;
-    if (parent) {
-        parentAngle = parent->WorldAngle();
+int32_t Stick::AngleUnits() const {
+    if (!IsDriven()) return utils::ToAngleUnits(angle);
+    const int64_t influence = utils::ToFixedQ16(driverInfluence);
+    const float offsetRadians = driverAngleOffset * Pi / 180.0f;
+    return int32_t(driver->AngleUnits() * influence / (1 << 16)) + utils::ToAngleUnits(offsetRadians);
+}
+
+bool Stick::CanBeDrivenBy(const Stick* stick) const {
+    for (const Stick* curr = stick; curr; curr = curr->driver) {
+        if (curr == this) return false;
     }
-    return Angle() + parentAngle;
+    return true;
+}
+
+double Stick::WorldAngle() const {
+    return cachedWorldAngle;
 }
 
 void Stick::SetWorldAngle(double newAngle, bool compensateChildren) {
@@ -98,6 +120,7 @@ void Stick::SetWorldAngle(double newAngle, bool compensateChildren) {
     }
     double prevAngle = angle;
     angle = newAngle - parentAngle;
+    UpdateTransforms();
 
     if (compensateChildren) {
         for (auto& child : children) {
@@ -106,52 +129,222 @@ void Stick::SetWorldAngle(double newAngle, bool compensateChildren) {
     }
 }
 
+void Stick::UpdateTransforms() {
+    olc::vi2d parentPos = olc::vi2d{ 0, 0 };
+    double parentAngle = 0.0;
+    if (parent) {
+        parentPos = parent->cachedWorldPos + parent->cachedTip;
+        parentAngle = parent->cachedWorldAngle;
+    }
+
+    cachedWorldPos = pos + parentPos;
+
+    if (utils::GetFixedPointMode()) {
+        // same integer math as Rig::EvaluateFixed, world angles are whole units so the parent's converts back exactly
+        const int32_t worldUnits = AngleUnits() + (parent ? utils::ToAngleUnits(parentAngle) : 0);
+        cachedWorldAngle = utils::FromAngleUnits(worldUnits);
+        if (len <= 0) {
+            cachedTip = olc::vi2d{ 0, 0 };
+        }
+        else {
+            int32_t s, c;
+            utils::SinCosQ30(worldUnits, s, c);
+            cachedTip = olc::vi2d{ int(int64_t(len) * c / (1 << 30)), int(int64_t(len) * s / (1 << 30)) };
+        }
+    }
+    else {
+        cachedWorldAngle = Angle() + parentAngle;
+        if (len <= 0) {
+            cachedTip = olc::vi2d{ 0, 0 };
+        }
+        else {
+            double c = std::cos(cachedWorldAngle) * len;
+            double s = std::sin(cachedWorldAngle) * len;
+            cachedTip = olc::vd2d{ c, s };
+        }
+    }
+
+    for (auto& child : children) {
+        child->UpdateTransforms();
+    }
+}
+
 bool Stick::HasAnimation(int frame) const {
-    auto stkPos = std::find_if(animation.begin(), animation.end(), [&](const StickKeyframe& a) {
-        return a.frame == frame;
+    auto stkPos = std::lower_bound(animation.begin(), animation.end(), frame, [](const StickKeyframe& a, int f) {
+        return a.frame < f;
     });
-    return stkPos != animation.end();
+    return stkPos != animation.end() && stkPos->frame == frame;
 }
 
-bool Stick::HasAnimationRecursive(int frame) {
-    bool hasAnim = HasAnimation(frame);
-    if (hasAnim) return true;
+int Stick::FindSegment(int frame) const {
+    if (animation.size() < 2) return -1;
 
-    for (auto& child : children) {
-        if (child->HasAnimationRecursive(frame)) return true;
+    auto next = std::upper_bound(animation.begin(), animation.end(), frame, [](int f, const StickKeyframe& a) {
+        return f < a.frame;
+    });
+    if (next == animation.begin() || next == animation.end()) return -1;
+    return int(next - animation.begin()) - 1;
+}
+
+int Stick::SeekSegment(int frame) {
+    const size_t count = animation.size();
+    if (count < 2) return -1;
+
+    if (animCursor + 1 < count) {
+        if (frame >= animation[animCursor].frame) {
+            if (frame < animation[animCursor + 1].frame) {
+                return int(animCursor);
+            }
+            if (animCursor + 2 < count && frame < animation[animCursor + 2].frame) {
+                return int(++animCursor);
+            }
+        }
+        else if (animCursor > 0 && frame >= animation[animCursor - 1].frame) {
+            return int(--animCursor);
+        }
+    }
+
+    int segment = FindSegment(frame);
+    if (segment >= 0) animCursor = size_t(segment);
+    return segment;
+}
+
+// Fixed-point keyframe interpolation, t in Q16
+static void LerpKeyframesFixed(const Stick& stick, const StickKeyframe& skf, const StickKeyframe& ekf, int32_t t, StickPose& pose) {
+    const int32_t units = utils::LerpAngleUnits(utils::ToAngleUnits(skf.angle), utils::ToAngleUnits(ekf.angle), t);
+    pose.angle = utils::FromAngleUnits(units);
+    if (!stick.parent)
+        pose.pos = olc::vi2d{ utils::LerpQ16(skf.pos.x, ekf.pos.x, t), utils::LerpQ16(skf.pos.y, ekf.pos.y, t) };
+}
+
+static void LerpKeyframes(const Stick& stick, const StickKeyframe& skf, const StickKeyframe& ekf, float t, StickPose& pose) {
+    pose.angle = utils::LerpAngle(skf.angle, ekf.angle, t);
+    if (!stick.parent)
+        pose.pos = olc::vf2d{ skf.pos }.lerp(olc::vf2d{ ekf.pos }, t);
+}
+
+// Pose of a stick at a frame inside the given segment. Only the root's position is animated.
+static void LerpSegment(const Stick& stick, int segment, int frame, StickPose& pose) {
+    auto& skf = stick.animation[segment];
+    auto& ekf = stick.animation[segment + 1];
+
+    if (utils::GetFixedPointMode()) {
+        LerpKeyframesFixed(stick, skf, ekf, int32_t((int64_t(frame - skf.frame) << 16) / (ekf.frame - skf.frame)), pose);
+        return;
     }
 
-    return false;
+    float t = float(frame - skf.frame) / (ekf.frame - skf.frame);
+    LerpKeyframes(stick, skf, ekf, t, pose);
+}
+
+// Interpolates frames [first, first + count) of a segment into a column of poses, `stride` apart.
+// The same math as LerpSegment, with the per-segment parts hoisted so the frame loop vectorizes.
+// Sticks other than the root keep heldPos.
+static void LerpSegmentRange(
+    const Stick& stick, const StickKeyframe& skf, const StickKeyframe& ekf, const olc::vi2d& heldPos,
+    int first, int count, StickPose* column, size_t stride,
+    std::vector<double>& angles, std::vector<float>& ts
+) {
+    const int span = ekf.frame - skf.frame;
+    const int offset = first - skf.frame;
+    angles.resize(count);
+    ts.resize(count);
+
+    if (utils::GetFixedPointMode()) {
+        const int32_t startUnits = utils::ToAngleUnits(skf.angle);
+        const int64_t delta = utils::AngleUnitsDelta(startUnits, utils::ToAngleUnits(ekf.angle));
+        for (int n = 0; n < count; n++) {
+            const int64_t t = (int64_t(offset + n) << 16) / span;
+            angles[n] = utils::FromAngleUnits(startUnits + int32_t(delta * t / (1 << 16)));
+        }
+        for (int n = 0; n < count; n++) {
+            StickPose& pose = column[n * stride];
+            pose.angle = angles[n];
+            if (!stick.parent) {
+                const int64_t t = (int64_t(offset + n) << 16) / span;
+                pose.pos = olc::vi2d{ utils::LerpQ16(skf.pos.x, ekf.pos.x, t), utils::LerpQ16(skf.pos.y, ekf.pos.y, t) };
+            }
+            else pose.pos = heldPos;
+        }
+        return;
+    }
+
+    const double startAngle = skf.angle;
+    const double delta = utils::ShortestAngleDelta(skf.angle, ekf.angle);
+    // inside a segment t is always in [0, 1), so LerpAngle's clamp can go and the loop stays branch-free
+    for (int n = 0; n < count; n++) {
+        const float t = float(offset + n) / span;
+        ts[n] = t;
+        angles[n] = startAngle + delta * t;
+    }
+    for (int n = 0; n < count; n++) {
+        StickPose& pose = column[n * stride];
+        pose.angle = angles[n];
+        pose.pos = stick.parent ? heldPos : olc::vi2d(olc::vf2d{ skf.pos }.lerp(olc::vf2d{ ekf.pos }, ts[n]));
+    }
 }
 
 void Stick::Animate(int frame) {
     if (animation.empty() || IsDriven()) return;
 
-    for (size_t i = 0; i < animation.size() - 1; i++) {
-        auto& skf = animation[i];
-        auto& ekf = animation[i + 1];
+    int segment = SeekSegment(frame);
+    if (segment < 0) return;
 
-        if (frame >= skf.frame && frame < ekf.frame) {
-            float t = float(frame - skf.frame) / (ekf.frame - skf.frame);
-            angle = utils::LerpAngle(skf.angle, ekf.angle, t);
-            if (!parent)
-                pos = olc::vf2d{ skf.pos }.lerp(olc::vf2d{ ekf.pos }, t);
-        }
+    StickPose pose{ pos, angle };
+    LerpSegment(*this, segment, frame, pose);
+    pos = pose.pos;
+    angle = pose.angle;
+}
+
+bool Stick::Sample(int frame, StickPose& pose) const {
+    if (animation.empty() || IsDriven()) return false;
+
+    int segment = FindSegment(frame);
+    if (segment < 0) return false;
+
+    LerpSegment(*this, segment, frame, pose);
+    return true;
+}
+
+void Stick::Animate(float time) {
+    if (animation.empty() || IsDriven()) return;
+
+    // keys sit on whole frames, so the segment holding the time is the one holding its frame
+    int segment = SeekSegment(int(std::floor(time)));
+    if (segment < 0) return;
+
+    auto& skf = animation[segment];
+    auto& ekf = animation[segment + 1];
+
+    StickPose pose{ pos, angle };
+    if (utils::GetFixedPointMode()) {
+        LerpKeyframesFixed(*this, skf, ekf, int32_t(std::lround((time - skf.frame) * 65536.0 / (ekf.frame - skf.frame))), pose);
     }
+    else {
+        float t = (time - float(skf.frame)) / (ekf.frame - skf.frame);
+        LerpKeyframes(*this, skf, ekf, t, pose);
+    }
+    pos = pose.pos;
+    angle = pose.angle;
 }
 
 void Stick::SetKeyframe(int frame) {
+    SetKeyframeSingle(frame, pos, angle);
+}
+
+void Stick::SetKeyframeSingle(int frame, const olc::vi2d& pos, double angle) {
     if (IsDriven()) return; // ignore driven sticks
 
-    auto stkPos = std::find_if(animation.begin(), animation.end(), [&](const StickKeyframe& a) {
-        return a.frame == frame;
+    auto stkPos = std::lower_bound(animation.begin(), animation.end(), frame, [](const StickKeyframe& a, int f) {
+        return a.frame < f;
     });
-    if (stkPos == animation.end()) { // then add it
+    if (stkPos == animation.end() || stkPos->frame != frame) { // then add it
         StickKeyframe kf{};
         kf.frame = frame;
         kf.pos = pos;
         kf.angle = angle;
-        animation.push_back(kf);
+        animation.insert(stkPos, kf);
+        if (figure) figure->KeyAdded(frame);
     }
     else {
         // edit it
@@ -160,50 +353,76 @@ void Stick::SetKeyframe(int frame) {
         kf.angle = angle;
     }
 
-    //for (auto& child : children) {
-    //    child->SetKeyframe(frame);
-    //}
-
-    auto compareKeyframes = [](const StickKeyframe& a, const StickKeyframe& b) {
-        return a.frame < b.frame;
-    };
-    std::sort(animation.begin(), animation.end(), compareKeyframes);
+    NotifyKeyframeChanged(frame);
 }
 
-void Stick::SetKeyframeSingle(int frame, const olc::vi2d& pos, double angle) {
+void Stick::AppendKeyframe(int frame, const olc::vi2d& pos, double angle) {
     if (IsDriven()) return; // ignore driven sticks
 
-    auto stkPos = std::find_if(animation.begin(), animation.end(), [&](const StickKeyframe& a) {
-        return a.frame == frame;
+    StickKeyframe kf{};
+    kf.frame = frame;
+    kf.pos = pos;
+    kf.angle = angle;
+    animation.push_back(kf);
+
+    if (figure) {
+        figure->KeyAdded(frame);
+        figure->KeyframesChanged(0, std::numeric_limits<int>::max());
+    }
+}
+
+void Stick::NotifyKeyframeChanged(int frame) {
+    if (!figure) return;
+
+    // playback interpolates [prev, frame) and [frame, next), and past the last key
+    // it holds the pose of the frame before it
+    auto next = std::upper_bound(animation.begin(), animation.end(), frame, [](int f, const StickKeyframe& a) {
+        return f < a.frame;
     });
-    if (stkPos == animation.end()) { // then add it
-    	StickKeyframe kf{};
-    	kf.frame = frame;
-    	kf.pos = pos;
-    	kf.angle = angle;
-    	animation.push_back(kf);
+    auto at = std::lower_bound(animation.begin(), animation.end(), frame, [](const StickKeyframe& a, int f) {
+        return a.frame < f;
+    });
+
+    int first = at != animation.begin() ? std::prev(at)->frame : frame;
+    int last = std::numeric_limits<int>::max();
+    if (next != animation.end() && std::next(next) != animation.end()) {
+        last = next->frame;
     }
-    else {
-		// edit it
-		auto& kf = *stkPos;
-		kf.pos = pos;
-		kf.angle = angle;
-	}
+    figure->KeyframesChanged(first, last);
+}
 
+void Stick::SortKeyframes() {
     auto compareKeyframes = [](const StickKeyframe& a, const StickKeyframe& b) {
         return a.frame < b.frame;
     };
-    std::sort(animation.begin(), animation.end(), compareKeyframes);
+    // saved files already come in order
+    if (!std::is_sorted(animation.begin(), animation.end(), compareKeyframes)) {
+        std::stable_sort(animation.begin(), animation.end(), compareKeyframes);
+    }
+
+    // repeated frames: the last one wins, same as calling SetKeyframeSingle for each
+    auto out = animation.begin();
+    for (auto it = animation.begin(); it != animation.end(); ++it) {
+        auto next = it + 1;
+        if (next != animation.end() && next->frame == it->frame) {
+            if (figure) figure->KeyRemoved(it->frame);
+            continue;
+        }
+        *out++ = *it;
+    }
+    animation.erase(out, animation.end());
 }
 
 void Stick::DeleteKeyframe(int frame) {
     if (IsDriven()) return; // ignore driven sticks
 
-    auto stkPos = std::find_if(animation.begin(), animation.end(), [&](const StickKeyframe& a) {
-		return a.frame == frame;
+    auto stkPos = std::lower_bound(animation.begin(), animation.end(), frame, [](const StickKeyframe& a, int f) {
+		return a.frame < f;
 	});
-	if (stkPos != animation.end()) {
+	if (stkPos != animation.end() && stkPos->frame == frame) {
 		animation.erase(stkPos);
+        if (figure) figure->KeyRemoved(frame);
+        NotifyKeyframeChanged(frame);
 	}
 
 	for (auto& child : children) {
@@ -211,107 +430,67 @@ void Stick::DeleteKeyframe(int frame) {
 	}
 }
 
-int Stick::MaxFrames() const {
-    int maxFram = 0;
-    for (auto& kf : animation) {
-        maxFram = std::max(maxFram, kf.frame);
-    }
-
-    for (auto& child : children) {
-        maxFram = std::max(maxFram, child->MaxFrames());
-    }
-    return maxFram;
-}
-
 int Stick::NearFrameLeft(int frame) const {
     if (animation.empty()) return 0;
 
     if (frame > 0) frame--;
-    int lastFrame = animation.back().frame;
-    for (size_t i = 0; i < animation.size() - 1; i++) {
-        auto& skf = animation[i];
-        auto& ekf = animation[i + 1];
+    int segment = FindSegment(frame);
+    if (segment >= 0) return animation[segment].frame;
 
-        if (frame >= skf.frame && frame < ekf.frame) {
-            return skf.frame;
-        }
-
-        lastFrame = skf.frame;
-    }
-    return lastFrame;
+    // outside the track: the start of the last segment
+    return animation.size() > 1 ? animation[animation.size() - 2].frame : animation.back().frame;
 }
 
 int Stick::NearFrameRight(int frame) const {
     if (animation.empty()) return 0;
 
     if (frame > 0) frame--;
-    int lastFrame = animation.back().frame;
-    for (size_t i = 0; i < animation.size() - 1; i++) {
-        auto& skf = animation[i];
-        auto& ekf = animation[i + 1];
+    int segment = FindSegment(frame);
+    if (segment >= 0) return animation[segment + 1].frame;
 
-        if (frame >= skf.frame && frame < ekf.frame) {
-            return ekf.frame;
-        }
-
-        lastFrame = ekf.frame;
-    }
-    return lastFrame;
-}
-
-void Stick::SaveState() {
-    if (IsDriven()) return; // ignore driven sticks
-    tempAngle = angle;
-    tempPos = pos;
-    for (auto& child : children) {
-        child->SaveState();
-    }
-}
-
-void Stick::RestoreState() {
-    if (IsDriven()) return; // ignore driven sticks
-    angle = tempAngle;
-    pos = tempPos;
-    for (auto& child : children) {
-        child->RestoreState();
-    }
+    return animation.back().frame;
 }
 
+// Draws a segment as a capsule of the given half-width. The extra half pixel makes the caps
+// match FillCircle(width), which covers pixel centers up to about width + 0.5 away.
+// TileRenderer::AddStickShape mirrors this and DrawStickShape.
 static void DrawThickLine(
     olc::PixelGameEngine* pge,
     const olc::vi2d& p1, const olc::vi2d& p2,
     const olc::Pixel& color = olc::BLACK,
     int width = 3
 ) {
-    auto steps = (p2 - p1).mag() / width;
-
-    auto fp1 = olc::vf2d{ p1 };
-    auto fp2 = olc::vf2d{ p2 };
-    for (size_t i = 0; i < steps; i++) {
-        float fac = float(i) / steps;
-        auto p = fp1.lerp(fp2, fac);
-        pge->FillCircle(p, width, color);
-    }
+    utils::FillCapsule(pge, p1, p2, float(width) + 0.5f, color);
 }
 
-void Stick::Draw(olc::PixelGameEngine* pge, Stick* selected, const olc::vi2d& offset, const olc::Pixel& colorOverride) {
-    if (len <= 0 || !isVisible || isDriver) return;
-
-    olc::Pixel color = colorOverride.a > 0 ? colorOverride : this->color;
+void DrawStickShape(
+    olc::PixelGameEngine* pge,
+    const olc::vi2d& start, const olc::vi2d& tip,
+    int len, bool isCircle,
+    const olc::Pixel& color,
+    bool selected
+) {
     if (!isCircle) {
-        if (selected == this) {
-            DrawThickLine(pge, WorldPos() + offset, WorldPos() + Tip() + offset, olc::BLUE, 4);
+        if (selected) {
+            DrawThickLine(pge, start, start + tip, olc::BLUE, 4);
         }
-        DrawThickLine(pge, WorldPos() + offset, WorldPos() + Tip() + offset, color, 3);
+        DrawThickLine(pge, start, start + tip, color, 3);
     }
     else {
-        if (selected == this) {
-            pge->FillCircle(WorldPos() + Tip() / 2 + offset, len / 2 + 1, olc::BLUE);
+        if (selected) {
+            pge->FillCircle(start + tip / 2, len / 2 + 1, olc::BLUE);
         }
-        pge->FillCircle(WorldPos() + Tip() / 2 + offset, len / 2, color);
+        pge->FillCircle(start + tip / 2, len / 2, color);
     }
 }
 
+void Stick::Draw(olc::PixelGameEngine* pge, Stick* selected, const olc::vi2d& offset, const olc::Pixel& colorOverride) {
+    if (len <= 0 || !isVisible || isDriver) return;
+
+    olc::Pixel color = colorOverride.a > 0 ? colorOverride : this->color;
+    DrawStickShape(pge, WorldPos() + offset, Tip(), len, isCircle, color, selected == this);
+}
+
 void Stick::DrawManipulators(olc::PixelGameEngine* pge, const olc::vi2d& offset) {
     if (canMove()) {
         if (parent && len > 0) {
@@ -387,40 +566,6 @@ std::vector<Stick*> Stick::GetSticksRecursive() {
 	return sticks;
 }
 
-std::vector<Stick*> Stick::GetSticksRecursiveSorted() {
-    std::vector<Stick*> sticks;
-	sticks.push_back(this);
-    for (auto& child : children) {
-		auto childSticks = child->GetSticksRecursiveSorted();
-		sticks.insert(sticks.end(), childSticks.begin(), childSticks.end());
-	}
-
-	// sort by id
-    std::sort(sticks.begin(), sticks.end(), [](const Stick* a, const Stick* b) {
-		return a->drawOrder < b->drawOrder;
-	});
-
-	return sticks;
-}
-
-std::vector<Stick*> Stick::GetSticksRecursiveVisibleSorted() {
-    std::vector<Stick*> sticks;
-    if (isVisible) sticks.push_back(this);
-    for (auto& child : children) {
-        auto childSticks = child->GetSticksRecursiveVisibleSorted();
-        for (auto& childStick : childSticks) {
-            if (childStick->isVisible) sticks.push_back(childStick);
-		}
-	}
-
-    // sort by draw order
-    std::sort(sticks.begin(), sticks.end(), [](const Stick* a, const Stick* b) {
-		return a->drawOrder < b->drawOrder;
-	});
-
-    return sticks;
-}
-
 void Figure::LoadFromString(const std::string& data) {
     CommandFile cf;
     cf.LoadFromString(data);
@@ -435,15 +580,131 @@ void Figure::LoadFromFile(const std::string& fileName) {
     LoadFromString(data);
 }
 
-void Figure::LoadFromCommands(const std::vector<Command>& commands) {
-    std::map<int, std::unique_ptr<Stick>> sticks;
+std::vector<std::shared_ptr<Figure>> Figure::LoadAnimation(const std::string& fileName) {
+    CommandFile cf{};
+    cf.LoadFromFile(fileName);
 
+    std::vector<std::shared_ptr<Figure>> figures;
+    const std::vector<Command>& commands = cf.GetCommands();
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i].name != "fig") continue;
+
+        std::vector<Command> figureCommands;
+        while (i < commands.size() && commands[i].name != "figend") {
+            figureCommands.push_back(commands[i++]);
+        }
+
+        auto figure = std::make_shared<Figure>();
+        figure->LoadFromCommands(figureCommands);
+        figures.push_back(figure);
+    }
+    return figures;
+}
+
+void Figure::Reset() {
     root = std::make_unique<Stick>();
     root->id = 0;
     root->pos.x = 0;
     root->pos.y = 0;
     root->angle = 0;
     root->len = 0;
+    root->figure = this;
+    keyedFrames.clear();
+    stickIndex.clear();
+    stickIndex[root->id] = root.get();
+    Invalidate();
+}
+
+void Figure::Invalidate() {
+    rigDirty = true;
+    animationRevision++;
+    staleFirst = 0;
+    staleLast = std::numeric_limits<int>::max();
+}
+
+void Figure::KeyframesChanged(int first, int last) {
+    animationRevision++;
+    if (first >= last) return;
+
+    if (staleFirst >= staleLast) {
+        staleFirst = first;
+        staleLast = last;
+    }
+    else {
+        staleFirst = std::min(staleFirst, first);
+        staleLast = std::max(staleLast, last);
+    }
+}
+
+void Figure::InvalidatePose() {
+    poseEvaluated = false;
+    restStale = true;
+    staleFirst = 0;
+    staleLast = std::numeric_limits<int>::max();
+}
+
+Stick* Figure::FindStick(size_t id) const {
+    auto it = stickIndex.find(id);
+    return it != stickIndex.end() ? it->second : nullptr;
+}
+
+void Figure::IndexSticks(Stick* stick) {
+    stickIndex[stick->id] = stick;
+    for (auto& child : stick->children) {
+        IndexSticks(child.get());
+    }
+}
+
+void Figure::UnindexSticks(Stick* stick) {
+    auto it = stickIndex.find(stick->id);
+    if (it != stickIndex.end() && it->second == stick) {
+        stickIndex.erase(it);
+    }
+    for (auto& child : stick->children) {
+        UnindexSticks(child.get());
+    }
+}
+
+void Figure::KeyAdded(int frame) {
+    keyedFrames[frame]++;
+}
+
+void Figure::KeyRemoved(int frame) {
+    auto it = keyedFrames.find(frame);
+    if (it != keyedFrames.end() && --it->second <= 0) {
+        keyedFrames.erase(it);
+    }
+}
+
+int Figure::MaxFrames() const {
+    return keyedFrames.empty() ? 0 : std::max(keyedFrames.rbegin()->first, 0);
+}
+
+bool Figure::IsFrameKeyed(int frame) const {
+    return keyedFrames.find(frame) != keyedFrames.end();
+}
+
+int Figure::NextKeyedFrame(int frame) const {
+    auto it = keyedFrames.upper_bound(frame);
+    return it != keyedFrames.end() ? it->first : -1;
+}
+
+int Figure::PrevKeyedFrame(int frame) const {
+    auto it = keyedFrames.lower_bound(frame);
+    return it != keyedFrames.begin() ? std::prev(it)->first : -1;
+}
+
+std::pair<int, int> Figure::TakeStaleFrames() {
+    auto range = std::make_pair(staleFirst, staleLast);
+    staleFirst = staleLast = 0;
+    return range;
+}
+
+void Figure::LoadFromCommands(const std::vector<Command>& commands) {
+    std::map<int, std::unique_ptr<Stick>> sticks;
+
+    Reset();
+    loadWarnings.clear();
 
     for (auto&& cmd : commands) {
         if (cmd.name == "fig") {
@@ -484,6 +745,7 @@ void Figure::LoadFromCommands(const std::vector<Command>& commands) {
 
             auto stick = std::make_unique<Stick>();
             stick->id = id;
+            stick->figure = this;
             stick->pos.x = 0;
             stick->pos.y = 0;
             stick->angle = (angle * Pi / 180.0f);
@@ -514,13 +776,22 @@ void Figure::LoadFromCommands(const std::vector<Command>& commands) {
             float influence = float(cmd.GetOptionalArg<double>(2, 1.0));
             float angleOffset = float(cmd.GetOptionalArg<double>(3, 0.0));
 
-            Stick* stick = root->GetChild(stickId);
-            Stick* driver = root->GetChild(driverId);
+            Stick* stick = FindStick(stickId);
+            Stick* driver = FindStick(driverId);
 
             if (!stick || !driver) {
 				throw std::runtime_error("Stick or driver not found");
 			}
 
+            // a link closing a driver cycle can't be evaluated, the stick keeps its own angle
+            if (!stick->CanBeDrivenBy(driver)) {
+                loadWarnings.push_back(
+                    "Figure " + name + ": stick " + std::to_string(stickId) + " cannot be driven by stick "
+                    + std::to_string(driverId) + ", it would close a driver cycle. The link was dropped."
+                );
+                continue;
+            }
+
             stick->driver = driver;
             stick->driverInfluence = influence;
             stick->driverAngleOffset = angleOffset;
@@ -536,17 +807,16 @@ void Figure::LoadFromCommands(const std::vector<Command>& commands) {
 
             auto& child = sticks[childId];
 
-            if (parentId == 0) {
-                child->parent = root.get();
-                root->children.push_back(std::move(child));
+            Stick* parent = parentId == 0 ? root.get() : sticks[parentId].get();
+            if (!parent) {
+                parent = FindStick(parentId);
             }
-            else {
-                Stick* parent = sticks[parentId].get();
-                if (!parent) {
-                    parent = root->GetChild(parentId);
-                }
-                parent->children.push_back(std::move(child));
-                parent->children.back()->parent = parent;
+            parent->children.push_back(std::move(child));
+            parent->children.back()->parent = parent;
+
+            // sticks only become reachable once their branch hangs from the root
+            if (FindStick(parent->id) == parent) {
+                IndexSticks(parent->children.back().get());
             }
         }
         else if (cmd.name == "figend") {
@@ -560,9 +830,9 @@ void Figure::LoadFromCommands(const std::vector<Command>& commands) {
                 posY = int(cmd.GetArg<double>(3));
             double angle = cmd.GetArg<double>(4);
 
-            Stick* stick = root->GetChild(id);
+            Stick* stick = FindStick(id);
             if (stick) {
-				stick->SetKeyframeSingle(frame, olc::vi2d{ posX, posY }, angle * Pi / 180.0f);
+				stick->AppendKeyframe(frame, olc::vi2d{ posX, posY }, angle * Pi / 180.0f);
 			}
         }
         else if (cmd.name == "pos") {
@@ -570,6 +840,219 @@ void Figure::LoadFromCommands(const std::vector<Command>& commands) {
 			root->pos.y = int(cmd.GetArg<double>(1));
 		}
     }
+
+    for (auto stick : root->GetSticksRecursive()) {
+        stick->SortKeyframes();
+    }
+
+    Compile();
+    UpdateTransforms();
+}
+
+void Figure::Compile() {
+    rig.Compile(root.get());
+    rigDirty = false;
+    rigRevision = ++gRigRevision;
+}
+
+Rig& Figure::GetRig() {
+    if (rigDirty) Compile();
+    return rig;
+}
+
+void Figure::CapturePose(StickPose* out) {
+    Rig& r = GetRig();
+    for (size_t i = 0; i < r.sticks.size(); i++) {
+        out[i] = StickPose{ r.sticks[i]->pos, r.sticks[i]->angle };
+    }
+}
+
+void Figure::ApplyPose(const StickPose* pose) {
+    Rig& r = GetRig();
+    for (size_t i = 0; i < r.sticks.size(); i++) {
+        r.sticks[i]->pos = pose[i].pos;
+        r.sticks[i]->angle = pose[i].angle;
+    }
+}
+
+void Figure::CapturePose(Pose& out) {
+    out.sticks.resize(GetRig().Size());
+    CapturePose(out.sticks.data());
+}
+
+void Figure::ApplyPose(const Pose& pose) {
+    if (pose.Size() != GetRig().Size()) {
+        throw std::runtime_error("Pose doesn't match the figure's sticks");
+    }
+    ApplyPose(pose.sticks.data());
+}
+
+void Figure::EvaluatePose(int frame, Pose& out) {
+    CapturePose(out);
+
+    const Rig& r = GetRig();
+    for (size_t i = 0; i < r.sticks.size(); i++) {
+        r.sticks[i]->Sample(frame, out.sticks[i]);
+    }
+}
+
+void Figure::EvaluateRange(int first, int last, const StickPose* start, StickPose* out, size_t stride) {
+    if (first >= last) return;
+
+    const Rig& r = GetRig();
+    if (stride == 0) stride = r.Size();
+
+    std::vector<double> angles;
+    std::vector<float> ts;
+
+    // stick by stick, so each track is walked once and every segment fills a run of frames
+    for (size_t i = 0; i < r.Size(); i++) {
+        const Stick& stick = *r.sticks[i];
+        const auto& track = stick.animation;
+        StickPose* column = out + i;
+
+        // the pose a stick keeps outside of its track, like sequential Animate calls
+        StickPose held = start[i];
+        int frame = first;
+
+        auto hold = [&](int until) {
+            for (; frame < until; frame++) column[size_t(frame - first) * stride] = held;
+        };
+
+        if (track.size() >= 2 && !stick.IsDriven()) {
+            // first segment that can contain frames from first on
+            auto next = std::upper_bound(track.begin(), track.end(), first, [](int f, const StickKeyframe& a) {
+                return f < a.frame;
+            });
+            size_t k = next == track.begin() ? 0 : size_t(next - track.begin()) - 1;
+
+            for (; k + 1 < track.size() && frame < last; k++) {
+                const StickKeyframe& skf = track[k];
+                const StickKeyframe& ekf = track[k + 1];
+
+                const int segmentFirst = std::min(std::max(frame, skf.frame), last);
+                const int segmentLast = std::min(ekf.frame, last);
+                hold(segmentFirst);
+                if (segmentFirst >= segmentLast) continue;
+
+                StickPose* rows = column + size_t(segmentFirst - first) * stride;
+                LerpSegmentRange(stick, skf, ekf, held.pos, segmentFirst, segmentLast - segmentFirst, rows, stride, angles, ts);
+                frame = segmentLast;
+                held = column[size_t(frame - 1 - first) * stride];
+            }
+        }
+
+        hold(last);
+    }
+}
+
+void Figure::DrawPose(olc::PixelGameEngine* pge, const StickPose* pose, const olc::vi2d& offset, const olc::Pixel& colorOverride) {
+    if (!root) return;
+    if (rigDirty) Compile();
+
+    // evaluates in the rig's scratch arrays only, the sticks' cached transforms keep the live pose
+    rigHoldsLivePose = false;
+    rig.Pull(pose);
+    rig.Evaluate();
+    rig.Draw(pge, offset, colorOverride);
+}
+
+void Figure::CollectPoseShapes(const StickPose* pose, std::vector<StickShape>& out, bool subPixel, const olc::Pixel& colorOverride) {
+    if (!root) return;
+    if (rigDirty) Compile();
+
+    rigHoldsLivePose = false;
+    rig.Pull(pose);
+    rig.Evaluate();
+    rig.CollectShapes(out, subPixel, colorOverride);
+}
+
+void Figure::UpdateTransforms() {
+    if (!root) return;
+    if (rigDirty) Compile();
+
+    // nothing to evaluate if the rig still holds this very pose, evaluated the same way
+    const size_t count = rig.sticks.size();
+    const bool fixedPoint = utils::GetFixedPointMode();
+    bool changed = rigRevision != transformedRigRevision || fixedPoint != transformedFixedPoint || transformedPose.size() != count;
+    for (size_t i = 0; !changed && i < count; i++) {
+        changed = rig.sticks[i]->pos != transformedPose[i].pos || rig.sticks[i]->angle != transformedPose[i].angle;
+    }
+    if (!changed && rigHoldsLivePose) return;
+
+    rig.Pull();
+    rig.Evaluate();
+    rig.Push();
+    rigHoldsLivePose = true;
+    if (!changed) return;
+
+    transformedPose.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        transformedPose[i] = StickPose{ rig.pos[i], rig.angle[i] };
+    }
+    transformedRigRevision = rigRevision;
+    transformedFixedPoint = fixedPoint;
+    transformRevision = ++gTransformRevision;
+}
+
+bool Figure::Animate(int frame) {
+    if (!root) return false;
+    if (rigDirty) Compile();
+
+    if (poseEvaluated && frame == evaluatedFrame && animationRevision == evaluatedRevision) {
+        return false;
+    }
+
+    UpdateKeyRange();
+
+    poseEvaluated = true;
+    evaluatedFrame = frame;
+    evaluatedRevision = animationRevision;
+
+    // Stick::Animate leaves sticks alone outside of their tracks
+    if (frame < keyRangeFirst || frame >= keyRangeLast) return false;
+
+    for (Stick* stick : rig.sticks) {
+        stick->Animate(frame);
+    }
+    return true;
+}
+
+bool Figure::Animate(float time) {
+    const int frame = int(std::floor(time));
+    if (time == float(frame)) return Animate(frame);
+
+    if (!root) return false;
+    if (rigDirty) Compile();
+
+    UpdateKeyRange();
+
+    // a sub-frame pose doesn't match any frame, the next Animate(int) has to re-apply
+    poseEvaluated = false;
+
+    if (frame < keyRangeFirst || frame >= keyRangeLast) return false;
+
+    for (Stick* stick : rig.sticks) {
+        stick->Animate(time);
+    }
+    return true;
+}
+
+void Figure::UpdateKeyRange() {
+    if (keyRangeRevision == animationRevision) return;
+
+    keyRangeFirst = std::numeric_limits<int>::max();
+    keyRangeLast = std::numeric_limits<int>::min();
+    for (Stick* stick : rig.sticks) {
+        if (stick->animation.size() < 2 || stick->IsDriven()) continue;
+        keyRangeFirst = std::min(keyRangeFirst, stick->animation.front().frame);
+        keyRangeLast = std::max(keyRangeLast, stick->animation.back().frame);
+    }
+    keyRangeRevision = animationRevision;
+}
+
+void Figure::Draw(olc::PixelGameEngine* pge, const olc::vi2d& offset, const olc::Pixel& colorOverride) const {
+    rig.Draw(pge, offset, colorOverride);
 }
 
 static void SaveStick(CommandFile& cf, Stick* stick) {
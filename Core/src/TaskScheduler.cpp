@@ -0,0 +1,265 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+namespace {
+    // the worker the current thread is, if any
+    struct WorkerIdentity {
+        const TaskScheduler* scheduler{ nullptr };
+        size_t index{ 0 };
+    };
+    thread_local WorkerIdentity tWorker;
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        Wait();
+    }
+    catch (...) {}
+}
+
+void TaskGroup::Run(std::function<void()> task) {
+    m_pending++;
+
+    if (m_scheduler.IsSingleThreaded()) {
+        std::exception_ptr error;
+        try {
+            task();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        Finish(error);
+        return;
+    }
+
+    m_scheduler.Push(TaskScheduler::Task{ std::move(task), this });
+}
+
+void TaskGroup::Wait() {
+    while (m_pending > 0) {
+        if (m_scheduler.TryRunOne()) continue;
+
+        // nothing left to help with, sleep until a task shows up or the group is done
+        std::unique_lock<std::mutex> lock(m_scheduler.m_sleepMutex);
+        m_scheduler.m_sleep.wait(lock, [this] {
+            return m_pending == 0 || m_scheduler.m_queued > 0;
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::Finish(std::exception_ptr error) {
+    if (error) {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        if (!m_error) m_error = error;
+    }
+
+    // the waiter may be asleep, and may destroy the group as soon as the count hits 0,
+    // so the scheduler has to be read before
+    TaskScheduler& scheduler = m_scheduler;
+    if (--m_pending == 0) scheduler.Notify(true);
+}
+
+TaskScheduler::TaskScheduler(size_t threadCount) {
+    Start(threadCount);
+}
+
+TaskScheduler::~TaskScheduler() {
+    Stop();
+}
+
+size_t TaskScheduler::DefaultThreadCount() {
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+void TaskScheduler::SetThreadCount(size_t threadCount) {
+    if (threadCount == m_workers.size()) return;
+    Stop();
+    Start(threadCount);
+}
+
+void TaskScheduler::Start(size_t threadCount) {
+    m_stop = false;
+
+    m_workers.clear();
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // only start once every deque exists, workers steal from each other right away
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers[i]->thread = std::thread([this, i] { WorkerLoop(i); });
+    }
+}
+
+void TaskScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleep.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+    m_workers.clear();
+}
+
+void TaskScheduler::ParallelFor(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+
+    if (IsSingleThreaded() || end - begin <= grain) {
+        for (size_t i = begin; i < end; i++) body(i);
+        return;
+    }
+
+    TaskGroup group(*this);
+
+    // keep the first half, hand the second one out, repeat: the biggest chunks are the oldest
+    // tasks of a deque, which is what thieves take
+    std::function<void(size_t, size_t)> split = [&](size_t first, size_t last) {
+        while (last - first > grain) {
+            const size_t mid = first + (last - first) / 2;
+            group.Run([&split, mid, last] { split(mid, last); });
+            last = mid;
+        }
+        for (size_t i = first; i < last; i++) body(i);
+    };
+
+    // queued halves still use split, so even if our own part throws they have to finish first
+    std::exception_ptr error;
+    try {
+        split(begin, end);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    group.Wait();
+
+    if (error) std::rethrow_exception(error);
+}
+
+void TaskScheduler::PostToMainThread(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_mainTasks.push_back(std::move(task));
+}
+
+void TaskScheduler::RunMainThreadTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        tasks.swap(m_mainTasks);
+    }
+
+    // continuations may post new ones, those run next frame
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void TaskScheduler::Push(Task&& task) {
+    if (tWorker.scheduler == this) {
+        Worker& self = *m_workers[tWorker.index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        self.tasks.push_back(std::move(task));
+    }
+    else {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        m_inject.push_back(std::move(task));
+    }
+
+    m_queued++;
+    Notify(false);
+}
+
+bool TaskScheduler::TryPop(Task& task) {
+    if (m_queued == 0) return false;
+
+    const bool isWorker = tWorker.scheduler == this;
+
+    // own tasks first, newest first, they're the ones still warm in the cache
+    if (isWorker) {
+        Worker& self = *m_workers[tWorker.index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.tasks.empty()) {
+            task = std::move(self.tasks.back());
+            self.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        if (!m_inject.empty()) {
+            task = std::move(m_inject.front());
+            m_inject.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // steal the oldest task of someone else, starting with the next worker
+    const size_t count = m_workers.size();
+    const size_t start = isWorker ? tWorker.index + 1 : 0;
+    for (size_t n = 0; n < count; n++) {
+        Worker& victim = *m_workers[(start + n) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TaskScheduler::TryRunOne() {
+    Task task;
+    if (!TryPop(task)) return false;
+    Execute(task);
+    return true;
+}
+
+void TaskScheduler::Execute(Task& task) {
+    std::exception_ptr error;
+    try {
+        task.function();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    // release whatever the task captured before the group can be considered done
+    task.function = nullptr;
+    if (task.group) task.group->Finish(error);
+}
+
+void TaskScheduler::WorkerLoop(size_t index) {
+    tWorker = WorkerIdentity{ this, index };
+
+    for (;;) {
+        if (TryRunOne()) continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleep.wait(lock, [this] { return m_stop || m_queued > 0; });
+        if (m_stop) return;
+    }
+}
+
+void TaskScheduler::Notify(bool all) {
+    // taking the lock orders this with a sleeper checking its condition, so no wake-up gets lost
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    if (all) m_sleep.notify_all();
+    else m_sleep.notify_one();
+}
@@ -0,0 +1,170 @@
+#include "TileRenderer.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TileRenderer::Clear() {
+    m_primitives.clear();
+    m_capsules.clear();
+    m_circles.clear();
+    m_circleRows.clear();
+}
+
+void TileRenderer::AddCapsule(const olc::vi2d& a, const olc::vi2d& b, float radius, const olc::Pixel& color) {
+    utils::Capsule capsule(a, b, radius);
+    const int reach = int(std::ceil(capsule.radius));
+
+    Primitive primitive;
+    primitive.isCircle = false;
+    primitive.index = uint32_t(m_capsules.size());
+    primitive.left = std::min(a.x, b.x) - reach;
+    primitive.right = std::max(a.x, b.x) + reach;
+    primitive.top = capsule.top;
+    primitive.bottom = capsule.bottom;
+    primitive.color = color;
+
+    m_capsules.push_back(capsule);
+    m_primitives.push_back(primitive);
+}
+
+void TileRenderer::AddCircle(const olc::vi2d& center, int radius, const olc::Pixel& color) {
+    if (radius < 0) return;
+
+    const size_t rows = m_circleRows.size();
+    m_circleRows.resize(rows + 2 * radius + 1, -1);
+    int* halfWidth = &m_circleRows[rows + radius];
+
+    // the midpoint loop of PixelGameEngine::FillCircle, recording row widths instead of drawing.
+    // Rows it draws more than once are centered alike, so the widest one is their union.
+    auto line = [&](int half, int dy) { halfWidth[dy] = std::max(halfWidth[dy], half); };
+    if (radius > 0) {
+        int x0 = 0;
+        int y0 = radius;
+        int d = 3 - 2 * radius;
+        while (y0 >= x0) {
+            line(y0, -x0);
+            if (x0 > 0) line(y0, x0);
+
+            if (d < 0)
+                d += 4 * x0++ + 6;
+            else {
+                if (x0 != y0) {
+                    line(x0, -y0);
+                    line(x0, y0);
+                }
+                d += 4 * (x0++ - y0--) + 10;
+            }
+        }
+    }
+    else {
+        line(0, 0);
+    }
+
+    Primitive primitive;
+    primitive.isCircle = true;
+    primitive.index = uint32_t(m_circles.size());
+    primitive.left = center.x - radius;
+    primitive.right = center.x + radius;
+    primitive.top = center.y - radius;
+    primitive.bottom = center.y + radius;
+    primitive.color = color;
+
+    m_circles.push_back(Circle{ center.x, center.y, radius, rows });
+    m_primitives.push_back(primitive);
+}
+
+void TileRenderer::AddStickShape(
+    const olc::vi2d& start, const olc::vi2d& tip,
+    int len, bool isCircle,
+    const olc::Pixel& color,
+    bool selected
+) {
+    // keep in sync with DrawStickShape and DrawThickLine in Stick.cpp
+    if (!isCircle) {
+        if (selected) {
+            AddCapsule(start, start + tip, 4.5f, olc::BLUE);
+        }
+        AddCapsule(start, start + tip, 3.5f, color);
+    }
+    else {
+        if (selected) {
+            AddCircle(start + tip / 2, len / 2 + 1, olc::BLUE);
+        }
+        AddCircle(start + tip / 2, len / 2, color);
+    }
+}
+
+void TileRenderer::Render(TaskScheduler& scheduler, olc::Sprite& target) {
+    Render(scheduler, target.GetData(), target.width, target.height, size_t(target.width));
+}
+
+void TileRenderer::Render(TaskScheduler& scheduler, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) {
+    if (!pixels || width <= 0 || height <= 0 || m_primitives.empty()) return;
+
+    m_tilesX = (width + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (height + m_tileSize - 1) / m_tileSize;
+    m_bins.resize(size_t(m_tilesX) * m_tilesY);
+    for (auto& bin : m_bins) bin.clear();
+
+    // binning by bounds, serially so every bin stays in submission order
+    for (uint32_t i = 0; i < uint32_t(m_primitives.size()); i++) {
+        const Primitive& p = m_primitives[i];
+        const int left = p.left - origin.x, right = p.right - origin.x;
+        const int top = p.top - origin.y, bottom = p.bottom - origin.y;
+        if (right < 0 || bottom < 0 || left >= width || top >= height) continue;
+
+        const int tx0 = std::max(left, 0) / m_tileSize;
+        const int ty0 = std::max(top, 0) / m_tileSize;
+        const int tx1 = std::min(right, width - 1) / m_tileSize;
+        const int ty1 = std::min(bottom, height - 1) / m_tileSize;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                m_bins[size_t(ty) * m_tilesX + tx].push_back(i);
+            }
+        }
+    }
+
+    // tiles don't share pixels, so they can be drawn in any order on any thread
+    scheduler.ParallelFor(0, m_bins.size(), [&](size_t tile) {
+        RenderTile(int(tile % m_tilesX), int(tile / m_tilesX), pixels, width, height, pitch, origin);
+    });
+}
+
+void TileRenderer::RenderTile(int tileX, int tileY, olc::Pixel* pixels, int width, int height, size_t pitch, const olc::vi2d& origin) const {
+    // in the primitives' coordinates
+    const int left = origin.x + tileX * m_tileSize;
+    const int top = origin.y + tileY * m_tileSize;
+    const int right = origin.x + std::min((tileX + 1) * m_tileSize, width) - 1;
+    const int bottom = origin.y + std::min((tileY + 1) * m_tileSize, height) - 1;
+
+    auto fill = [&](int y, int x0, int x1, const olc::Pixel& color) {
+        x0 = std::max(x0, left);
+        x1 = std::min(x1, right);
+        if (x0 > x1) return;
+        olc::Pixel* row = pixels + size_t(y - origin.y) * pitch;
+        std::fill(row + (x0 - origin.x), row + (x1 - origin.x) + 1, color);
+    };
+
+    for (uint32_t i : m_bins[size_t(tileY) * m_tilesX + tileX]) {
+        const Primitive& p = m_primitives[i];
+        const int y0 = std::max(p.top, top);
+        const int y1 = std::min(p.bottom, bottom);
+
+        if (p.isCircle) {
+            const Circle& circle = m_circles[p.index];
+            const int* halfWidth = &m_circleRows[circle.rows + circle.radius];
+            for (int y = y0; y <= y1; y++) {
+                const int half = halfWidth[y - circle.y];
+                if (half >= 0) fill(y, circle.x - half, circle.x + half, p.color);
+            }
+        }
+        else {
+            const utils::Capsule& capsule = m_capsules[p.index];
+            int x0, x1;
+            for (int y = y0; y <= y1; y++) {
+                if (capsule.Span(y, x0, x1)) fill(y, x0, x1, p.color);
+            }
+        }
+    }
+}
@@ -15,10 +15,14 @@ namespace utils {
         return std::clamp(t - std::floor(t / maxVal) * maxVal, 0.0, maxVal);
     }
 
-    // Function to lerp between two angles
-    double LerpAngle(double startAngle, double endAngle, float t) {
+    double ShortestAngleDelta(double startAngle, double endAngle) {
         double delta = Repeat(endAngle - startAngle, 2.0 * Pi);
         if (delta > Pi) delta -= 2.0 * Pi;
-        return startAngle + delta * std::clamp(t, 0.0f, 1.0f);
+        return delta;
+    }
+
+    // Function to lerp between two angles
+    double LerpAngle(double startAngle, double endAngle, float t) {
+        return startAngle + ShortestAngleDelta(startAngle, endAngle) * std::clamp(t, 0.0f, 1.0f);
     }
 }
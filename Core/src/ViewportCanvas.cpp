@@ -0,0 +1,222 @@
+#include "ViewportCanvas.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool ViewportCanvas::Bounds::Overlaps(const Bounds& other) const {
+    return left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom;
+}
+
+void ViewportCanvas::Bounds::Merge(const Bounds& other) {
+    if (other.IsEmpty()) return;
+    if (IsEmpty()) {
+        *this = other;
+        return;
+    }
+    left = std::min(left, other.left);
+    top = std::min(top, other.top);
+    right = std::max(right, other.right);
+    bottom = std::max(bottom, other.bottom);
+}
+
+ViewportCanvas::ViewportCanvas(int width, int height) : m_canvas(width, height) {}
+
+void ViewportCanvas::SetBackground(const olc::Pixel& color) {
+    if (color == m_background) return;
+    m_background = color;
+    m_invalid = true;
+}
+
+void ViewportCanvas::SetAntiAliased(bool antiAliased) {
+    if (antiAliased == m_antiAliased) return;
+    m_antiAliased = antiAliased;
+    m_invalid = true;
+}
+
+void ViewportCanvas::BeginFrame() {
+    std::swap(m_layers, m_previous);
+    m_previousCount = m_layerCount;
+    m_layerCount = 0;
+}
+
+std::vector<StickShape>* ViewportCanvas::AddLayer(uint64_t key, uint64_t revision) {
+    if (m_layerCount == m_layers.size()) m_layers.emplace_back();
+
+    Layer& layer = m_layers[m_layerCount++];
+    layer.key = key;
+    layer.revision = revision;
+    layer.kept = false;
+
+    // an invalid canvas may be drawn differently (e.g. anti-aliased shapes), everything is collected again
+    if (!m_invalid) {
+        for (size_t i = 0; i < m_previousCount; i++) {
+            Layer& previous = m_previous[i];
+            if (previous.key != key) continue;
+            if (previous.revision != revision) break;
+
+            // last frame's list won't be read again, take it rather than copy it
+            std::swap(layer.shapes, previous.shapes);
+            layer.bounds = previous.bounds;
+            layer.kept = true;
+            return nullptr;
+        }
+    }
+
+    layer.shapes.clear();
+    return &layer.shapes;
+}
+
+ViewportCanvas::Bounds ViewportCanvas::ShapeBounds(const std::vector<StickShape>& shapes) {
+    Bounds bounds{ 0, 0, -1, -1 };
+
+    // a little past the widest thing either renderer draws: radius 3.5 lines,
+    // FillCircle's radius + 0.5 and the half pixel coverage ramp
+    constexpr float LinePad = 5.0f;
+    constexpr float CirclePad = 3.0f;
+
+    for (const StickShape& shape : shapes) {
+        float x0, y0, x1, y1;
+        if (shape.isCircle) {
+            const olc::vf2d center = shape.start + shape.tip * 0.5f;
+            const float radius = shape.length * 0.5f + CirclePad;
+            x0 = center.x - radius;
+            y0 = center.y - radius;
+            x1 = center.x + radius;
+            y1 = center.y + radius;
+        }
+        else {
+            const olc::vf2d end = shape.start + shape.tip;
+            x0 = std::min(shape.start.x, end.x) - LinePad;
+            y0 = std::min(shape.start.y, end.y) - LinePad;
+            x1 = std::max(shape.start.x, end.x) + LinePad;
+            y1 = std::max(shape.start.y, end.y) + LinePad;
+        }
+        bounds.Merge(Bounds{ int(std::floor(x0)), int(std::floor(y0)), int(std::ceil(x1)), int(std::ceil(y1)) });
+    }
+    return bounds;
+}
+
+void ViewportCanvas::Damage(std::vector<Bounds>& rects, const Bounds& bounds) const {
+    Bounds clipped{
+        std::max(bounds.left, 0),
+        std::max(bounds.top, 0),
+        std::min(bounds.right, m_canvas.width - 1),
+        std::min(bounds.bottom, m_canvas.height - 1)
+    };
+    if (clipped.IsEmpty()) return;
+
+    // overlapping rectangles become one, so no pixel is drawn twice
+    for (;;) {
+        auto overlap = std::find_if(rects.begin(), rects.end(), [&](const Bounds& b) { return b.Overlaps(clipped); });
+        if (overlap == rects.end()) break;
+        clipped.Merge(*overlap);
+        *overlap = rects.back();
+        rects.pop_back();
+    }
+    rects.push_back(clipped);
+}
+
+void ViewportCanvas::EndFrame(TaskScheduler& scheduler) {
+    m_damage.clear();
+    m_redrawnPixels = 0;
+
+    for (size_t i = 0; i < m_layerCount; i++) {
+        if (!m_layers[i].kept) m_layers[i].bounds = ShapeBounds(m_layers[i].shapes);
+    }
+
+    // layers coming, going or changing places can uncover or cover anything, start over
+    bool sameLayers = m_layerCount == m_previousCount;
+    for (size_t i = 0; sameLayers && i < m_layerCount; i++) {
+        sameLayers = m_layers[i].key == m_previous[i].key;
+    }
+
+    if (m_invalid || !sameLayers) {
+        m_invalid = false;
+        Damage(m_damage, Bounds{ 0, 0, m_canvas.width - 1, m_canvas.height - 1 });
+    }
+    else {
+        for (size_t i = 0; i < m_layerCount; i++) {
+            const Layer& layer = m_layers[i];
+            const Layer& previous = m_previous[i];
+            if (layer.kept || layer.shapes == previous.shapes) continue;
+
+            Damage(m_damage, previous.bounds);
+            Damage(m_damage, layer.bounds);
+        }
+    }
+
+    for (const Bounds& bounds : m_damage) {
+        Redraw(scheduler, bounds);
+        Damage(m_unpresented, bounds);
+    }
+}
+
+void ViewportCanvas::Redraw(TaskScheduler& scheduler, const Bounds& bounds) {
+    const int width = bounds.right - bounds.left + 1;
+    const int height = bounds.bottom - bounds.top + 1;
+    const size_t pitch = size_t(m_canvas.width);
+    olc::Pixel* pixels = m_canvas.GetData() + size_t(bounds.top) * pitch + bounds.left;
+
+    for (int y = 0; y < height; y++) {
+        std::fill_n(pixels + size_t(y) * pitch, width, m_background);
+    }
+    m_redrawnPixels += size_t(width) * height;
+
+    // every layer touching the rectangle, in order, rasterized in canvas coordinates so the pixels
+    // are the same as redrawing the whole canvas
+    const olc::vi2d origin{ bounds.left, bounds.top };
+    if (m_antiAliased) {
+        m_smooth.Clear();
+        for (size_t i = 0; i < m_layerCount; i++) {
+            if (!m_layers[i].bounds.Overlaps(bounds)) continue;
+            for (const StickShape& shape : m_layers[i].shapes) {
+                m_smooth.AddStickShape(shape.start, shape.tip, shape.isCircle, shape.color);
+            }
+        }
+        m_smooth.Render(scheduler, pixels, width, height, pitch, origin);
+    }
+    else {
+        m_tiles.Clear();
+        for (size_t i = 0; i < m_layerCount; i++) {
+            if (!m_layers[i].bounds.Overlaps(bounds)) continue;
+            for (const StickShape& shape : m_layers[i].shapes) {
+                m_tiles.AddStickShape(olc::vi2d(shape.start), olc::vi2d(shape.tip), shape.length, shape.isCircle, shape.color);
+            }
+        }
+        m_tiles.Render(scheduler, pixels, width, height, pitch, origin);
+    }
+}
+
+void ViewportCanvas::MarkOverdrawn(const olc::vi2d& position, const olc::vi2d& size) {
+    Damage(m_unpresented, Bounds{ position.x, position.y, position.x + size.x - 1, position.y + size.y - 1 });
+}
+
+void ViewportCanvas::Present(olc::Sprite& target, const olc::vi2d& position) {
+    m_presentedPixels = 0;
+
+    // whatever is on the screen at a new position isn't the canvas
+    if (!m_presented || position != m_presentedAt) {
+        m_unpresented.clear();
+        Damage(m_unpresented, Bounds{ 0, 0, m_canvas.width - 1, m_canvas.height - 1 });
+        m_presented = true;
+        m_presentedAt = position;
+    }
+
+    for (const Bounds& bounds : m_unpresented) {
+        const int x0 = std::max(position.x + bounds.left, 0);
+        const int x1 = std::min(position.x + bounds.right + 1, target.width);
+        if (x0 >= x1) continue;
+
+        const int y0 = std::max(position.y + bounds.top, 0);
+        const int y1 = std::min(position.y + bounds.bottom + 1, target.height);
+        for (int y = y0; y < y1; y++) {
+            const olc::Pixel* src = m_canvas.pColData.data() + size_t(y - position.y) * m_canvas.width + (x0 - position.x);
+            olc::Pixel* dst = target.GetData() + size_t(y) * target.width + x0;
+            std::memcpy(dst, src, sizeof(olc::Pixel) * (x1 - x0));
+        }
+        m_presentedPixels += size_t(x1 - x0) * std::max(y1 - y0, 0);
+    }
+    m_unpresented.clear();
+}
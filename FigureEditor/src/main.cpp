@@ -67,7 +67,7 @@ public:
 		oldAngle(oldAngle),
 		color(color),
 		oldColor(oldColor),
-		stick(stick)
+		stickId(stick->id)
 	{}
 
 	void Execute() override;
@@ -77,7 +77,7 @@ public:
 	double angle{ 0.0 }, oldAngle{ 0.0 };
 	olc::Pixel color{ olc::BLACK }, oldColor{ olc::BLACK };
 
-	Stick* stick{ nullptr };
+	size_t stickId{ 0 };
 	FigureEditor* editor{ nullptr };
 };
 
@@ -98,7 +98,7 @@ public:
 		gui.baseColor = olc::Pixel(207, 194, 157);
 
 		figure.name = "Untitled";
-		figure.root = std::make_unique<Stick>();
+		figure.Reset();
 		figure.root->pos = olc::vi2d{ ScreenWidth() / 2, ScreenHeight() / 2 };
 
 		selectedStick = figure.root.get();
@@ -129,7 +129,10 @@ public:
 					angle = std::fmod(angle + Pi, 2.0 * Pi) - Pi;
 
 					selectedStick->SetWorldAngle(angle, false);
-					if (editLength) selectedStick->len = std::clamp(vec.mag(), 0, 100);
+					if (editLength) {
+						selectedStick->len = std::clamp(vec.mag(), 0, 100);
+						figure.Invalidate();
+					}
 					SelectStick(selectedStick);
 					isSaved = false;
 				} break;
@@ -219,8 +222,12 @@ public:
 				)->Execute();
 			}
 
-			gui.Toggle("chk_visible", gui.RectCutTop(11), "Is Visible", selectedStick->isVisible);
-			gui.Toggle("chk_circle", gui.RectCutTop(11), "Is Circle", selectedStick->isCircle);
+			if (gui.Toggle("chk_visible", gui.RectCutTop(11), "Is Visible", selectedStick->isVisible)) {
+				figure.Invalidate();
+			}
+			if (gui.Toggle("chk_circle", gui.RectCutTop(11), "Is Circle", selectedStick->isCircle)) {
+				figure.Invalidate();
+			}
 			//gui.Toggle("chk_driver", gui.RectCutTop(11), "Is Driver", selectedStick->isDriver);
 		} else {
 			gui.Label(gui.RectCutTop(11), "[Root Stick]", false, olc::BLACK);
@@ -237,7 +244,9 @@ public:
 				gui.ShowPopup("popup_motion_type");
 			}
 
-			gui.Spinner("spn_len", gui.RectCutTop(11), selectedStick->len, 0, 100, 1, "Len. %d");
+			if (gui.Spinner("spn_len", gui.RectCutTop(11), selectedStick->len, 0, 100, 1, "Len. %d")) {
+				figure.Invalidate();
+			}
 			if (gui.Spinner("spn_ang", gui.RectCutTop(11), angleDeg, -180, 180, 1, "Ang. %d")) {
 				selectedStick->angle = angleDeg * Pi / 180.0f;
 			}
@@ -269,7 +278,9 @@ public:
 			}
 
 			// TODO: undo/redo
-			gui.Spinner("spn_draworder", gui.RectCutTop(11), selectedStick->drawOrder, 0, 999, 1, "Order: %d");
+			if (gui.Spinner("spn_draworder", gui.RectCutTop(11), selectedStick->drawOrder, 0, 999, 1, "Order: %d")) {
+				figure.Invalidate();
+			}
 		}
 		gui.PopRect(); // stick props area
 
@@ -293,11 +304,16 @@ public:
 					selectedStick->driver->isDriver = false;
 					selectedStick->driver->driver = nullptr;
 					selectedStick->driver = nullptr;
+					figure.Invalidate();
 				}
 				gui.Label(gui.RectCutTop(11), "Stk #" + std::to_string(selectedStick->driver->id));
 
-				gui.SpinnerF("spn_driver_influence", gui.RectCutTop(11), selectedStick->driverInfluence, -1.0f, 1.0f, 0.01f, "Infl.: %.2f");
-				gui.SpinnerF("spn_driver_angle_offset", gui.RectCutTop(11), selectedStick->driverAngleOffset, -180.0f, 180.0f, 1.0f, "Off.: %.2f");
+				if (gui.SpinnerF("spn_driver_influence", gui.RectCutTop(11), selectedStick->driverInfluence, -1.0f, 1.0f, 0.01f, "Infl.: %.2f")) {
+					figure.Invalidate();
+				}
+				if (gui.SpinnerF("spn_driver_angle_offset", gui.RectCutTop(11), selectedStick->driverAngleOffset, -180.0f, 180.0f, 1.0f, "Off.: %.2f")) {
+					figure.Invalidate();
+				}
 			}
 		}
 		gui.PopRect(); // stick props area
@@ -381,7 +397,9 @@ public:
 	}
 
 	void DrawFigure(Figure& fig) {
-		auto sticks = fig.root->GetSticksRecursiveSorted();
+		fig.UpdateTransforms();
+
+		auto& sticks = fig.GetSticksSorted();
 
 		for (auto stk : sticks) {
 			auto [mode, stick] = stk->GetStickForManipulation(this, { 0, 0 }, true);
@@ -394,8 +412,12 @@ public:
 					moving = true;
 
 					if (pickingDriver && selectedStick) {
-						stick->isDriver = true;
-						selectedStick->driver = stick;
+						// a stick can't end up driving itself through a chain
+						if (selectedStick->CanBeDrivenBy(stick)) {
+							stick->isDriver = true;
+							selectedStick->driver = stick;
+							fig.Invalidate();
+						}
 						pickingDriver = false;
 					}
 				}
@@ -442,10 +464,23 @@ public:
 		return 2;
 	}
 
+	// tells what a load dropped from the file, before a save can overwrite it without
+	void ShowLoadWarnings(const std::vector<std::string>& warnings) {
+		if (warnings.empty()) return;
+
+		std::string message = "Parts of the file could not be used and will be left out when it is saved:\n";
+		for (auto& warning : warnings) message += "\n" + warning;
+		// the dialogs refuse messages with quotes, figure names may have them
+		std::replace(message.begin(), message.end(), '\'', '`');
+		std::replace(message.begin(), message.end(), '"', '`');
+
+		tinyfd_messageBox("StickMator", message.c_str(), "ok", "warning", 0);
+	}
+
 	void act_New() {
 		figure = Figure{};
 		figure.name = "Untitled";
-		figure.root = std::make_unique<Stick>();
+		figure.Reset();
 		figure.root->pos = olc::vi2d{ ScreenWidth() / 2, ScreenHeight() / 2 };
 		selectedStick = figure.root.get();
 		SelectStick(figure.root.get());
@@ -497,6 +532,7 @@ public:
 		if (ofdRes) {
 			act_New();
 			figure.LoadFromFile(ofdRes);
+			ShowLoadWarnings(figure.loadWarnings);
 			SelectStick(figure.root.get());
 			fileName = ofdRes;
 			isSaved = true;
@@ -591,13 +627,21 @@ void DelStickCommand::Undo() {
 }
 
 void ChangeStickCommand::Execute() {
+	Stick* stick = editor->figure.FindStick(stickId);
+	if (!stick) return;
+
 	stick->len = len;
 	stick->angle = angle;
 	stick->color = color;
+	editor->figure.Invalidate();
 }
 
 void ChangeStickCommand::Undo() {
+	Stick* stick = editor->figure.FindStick(stickId);
+	if (!stick) return;
+
 	stick->len = oldLen;
 	stick->angle = oldAngle;
 	stick->color = oldColor;
+	editor->figure.Invalidate();
 }
@@ -1,6 +1,11 @@
 ﻿#include <olcPixelGameEngine.h>
 #include <olcPGEX_TinyGUI.h>
 #include <Stick.h>
+#include <PoseCache.h>
+#include <TaskScheduler.h>
+#include <OffscreenRenderer.h>
+#include <ViewportCanvas.h>
+#include <FixedTrig.h>
 #include <CommandFile.h>
 #include <tinyFileDialogs.h>
 #include <UndoRedo.h>
@@ -8,6 +13,7 @@
 #include <gif.h>
 
 #include <filesystem>
+#include <unordered_map>
 
 #ifdef None
 #undef None
@@ -24,7 +30,7 @@ class StickMator;
 
 class AddFigureCommand : public IActionCommand {
 public:
-    AddFigureCommand(StickMator* app, const std::vector<Command>& commands)
+    AddFigureCommand(StickMator* app, std::shared_ptr<const std::vector<Command>> commands)
         : app(app), commands(commands) {}
 
     void Execute() override;
@@ -33,7 +39,7 @@ public:
     StickMator* app;
     std::shared_ptr<Figure> figure{ nullptr };
     olc::vi2d rootPos;
-    std::vector<Command> commands;
+    std::shared_ptr<const std::vector<Command>> commands; // shared with the figure file cache
     int savedId{ -1 };
 };
 
@@ -54,8 +60,10 @@ public:
 
 class MoveStickCommand : public IActionCommand {
 public:
-	MoveStickCommand(Stick* stick, olc::vi2d prevPos, double prevAngle, olc::vi2d pos, double angle)
-		: stick(stick),
+	MoveStickCommand(StickMator* app, Stick* stick, olc::vi2d prevPos, double prevAngle, olc::vi2d pos, double angle)
+		: app(app),
+        figureId(stick->figure->id),
+        stickId(stick->id),
         prevPos(prevPos),
         prevAngle(prevAngle),
         pos(pos),
@@ -65,7 +73,10 @@ public:
     void Execute() override;
     void Undo() override;
 
-	Stick* stick;
+    // ids instead of pointers, deleting and restoring a figure recreates its sticks
+	StickMator* app;
+    int figureId;
+    size_t stickId;
 	olc::vi2d pos, prevPos;
     double angle, prevAngle;
 };
@@ -137,9 +148,11 @@ public:
 
     bool OnUserUpdate(float fElapsedTime) override
     {
-        Clear(gui.PixelBrightness(gui.baseColor, 0.4f));
-        
+        scheduler.RunMainThreadTasks();
+
         Stick* selectedRoot = selectedStick ? selectedStick->GetRoot() : nullptr;
+        Figure* selectedFigure = selectedStick ? selectedStick->figure : nullptr;
+        const int maxFrames = MaxFramesAll();
 
         auto animTickDrawFn = [&](olc::PixelGameEngine* pge, int value, int min, int max, Rect bounds) {
             int tickX = bounds.x + (bounds.width * value) / (max - min);
@@ -148,10 +161,10 @@ public:
             int tickWidth = (int)std::round(float(bounds.width) / (max - min));
             if (tickWidth <= 0) return;
 
-            if (selectedRoot) {
+            if (selectedFigure) {
                 pge->FillRect(
                     tickX, tickY, tickWidth, 11,
-                    selectedRoot->HasAnimationRecursive(value) ? olc::YELLOW : olc::DARK_GREY
+                    selectedFigure->IsFrameKeyed(value) ? olc::YELLOW : olc::DARK_GREY
                 );
             }
 
@@ -168,16 +181,16 @@ public:
         );
 
         if (gui.Button("mnu_file", gui.RectCutLeft(30), "File")) {
-			gui.ShowPopup("popup_file");
+			ShowMenu("popup_file");
 		}
         if (gui.Button("mnu_figure_edit", gui.RectCutLeft(40), "Figures")) {
-            gui.ShowPopup("popup_figure_edit");
+            ShowMenu("popup_figure_edit");
         }
         if (gui.Button("mnu_edit", gui.RectCutLeft(30), "Edit")) {
-            gui.ShowPopup("popup_edit");
+            ShowMenu("popup_edit");
         }
         if (gui.Button("mnu_about", gui.RectCutLeft(30), "About")) {
-			gui.ShowPopup("popup_about");
+			ShowMenu("popup_about");
 		}
 
         gui.PopRect(); // menu area
@@ -198,6 +211,8 @@ public:
         if (gui.Button("play_pause", gui.RectCutLeft(gui.PeekRect().width / 2), playing ? "Pause" : "Play")) {
             playing = !playing;
             timer = 0.0f;
+            // editing happens on whole frames
+            if (!playing) AnimateAll(currentFrame);
         }
         if (gui.Button("stop", gui.PeekRect(), "Stop")) {
             playing = false;
@@ -213,9 +228,9 @@ public:
         if (gui.Spinner(
             "frame",
             gui.PeekRect(),
-            currentFrame, 0, std::max(int(MaxFramesAll()), 100), 1,
+            currentFrame, 0, std::max(maxFrames, 100), 1,
             "Fr. %d",
-            selectedRoot && selectedRoot->HasAnimationRecursive(currentFrame) ? olc::YELLOW : olc::Pixel(0, 0, 0, 0)
+            selectedFigure && selectedFigure->IsFrameKeyed(currentFrame) ? olc::YELLOW : olc::Pixel(0, 0, 0, 0)
         )) {
             AnimateAll(currentFrame);
         }
@@ -235,7 +250,7 @@ public:
         if (gui.Slider(
             "frame_slider",
             gui.RectCutTop(14),
-            currentFrame, 0, std::max(int(MaxFramesAll()), 100),
+            currentFrame, 0, std::max(maxFrames, 100),
             animTickDrawFn
         )) {
             AnimateAll(currentFrame);
@@ -250,15 +265,45 @@ public:
         int screenCenterX = viewportArea.x + (viewportArea.width / 2 - gScreenWidth / 2);
         int screenCenterY = viewportArea.y + (viewportArea.height / 2 - gScreenHeight / 2);
 
-        FillRect(screenCenterX, screenCenterY, gScreenWidth, gScreenHeight, olc::WHITE);
-
+        // the window isn't cleared, every area repaints itself: the GUI strips above, the canvas and its margins here.
+        // The margins and the canvas only need it after moving or when last frame's popup may have gone away
         auto offset = olc::vi2d(screenCenterX, screenCenterY);
+        const bool moved = viewportArea.Position() != lastViewportArea.Position() || viewportArea.Size() != lastViewportArea.Size();
+        if (moved || popupClosing) {
+            const olc::Pixel margin = gui.PixelBrightness(gui.baseColor, 0.4f);
+            const int canvasBottom = screenCenterY + gScreenHeight;
+            const int canvasRight = screenCenterX + gScreenWidth;
+            FillRect(viewportArea.x, viewportArea.y, viewportArea.width, screenCenterY - viewportArea.y, margin);
+            FillRect(viewportArea.x, canvasBottom, viewportArea.width, viewportArea.y + viewportArea.height - canvasBottom, margin);
+            FillRect(viewportArea.x, screenCenterY, screenCenterX - viewportArea.x, gScreenHeight, margin);
+            FillRect(canvasRight, screenCenterY, viewportArea.x + viewportArea.width - canvasRight, gScreenHeight, margin);
+            canvas.MarkOverdrawn({ 0, 0 }, { gScreenWidth, gScreenHeight });
+            lastViewportArea = viewportArea;
+            popupClosing = false;
+        }
+
+        // figures are rasterized into the persistent canvas, only where something changed since last frame,
+        // and only figures whose pose changed are evaluated and collected again.
+        // Transforms come first, the onion skins start from the live pose
+        UpdateAllTransforms();
+
+        canvas.SetAntiAliased(antiAliased);
+        canvas.BeginFrame();
         for (auto& fig : figures) {
-            DrawOnionSkin(*fig, offset);
+            SubmitOnionSkin(*fig);
         }
+        for (auto& fig : figures) {
+            if (auto shapes = canvas.AddLayer(CanvasLayerKey(*fig, false), fig->transformRevision)) {
+                // re-evaluates only if an onion skin evaluated its ghost in the rig meanwhile
+                fig->UpdateTransforms();
+                fig->CollectShapes(*shapes, antiAliased);
+            }
+        }
+        canvas.EndFrame(scheduler);
+        canvas.Present(*GetDrawTarget(), offset);
 
         for (auto& fig : figures) {
-            DrawFigure(*fig, offset);
+            ManipulateFigure(*fig, offset);
         }
 
         // ----- POPUPS -----
@@ -272,7 +317,7 @@ public:
             "-",
 			"Exit"
 		}; // BRB!!
-        if (gui.MakePopup("popup_file", mnuFileItems, 8, mnuSelFile)) {
+        if (MenuPopup("popup_file", mnuFileItems, 8, mnuSelFile)) {
             switch (mnuSelFile) {
                 case 0: mnu_FileNewAction(); break;
                 case 1: mnu_FileOpenAction(); break;
@@ -287,18 +332,39 @@ public:
             "Undo",
             "Redo",
             "-",
-            "Delete Selected"
+            "Delete Selected",
+            "-",
+            bakedPlayback ? "Baked Playback: On" : "Baked Playback: Off",
+            utils::GetFixedPointMode() ? "Fixed-Point Eval: On" : "Fixed-Point Eval: Off",
+            scheduler.IsSingleThreaded() ? "Single-Threaded: On" : "Single-Threaded: Off",
+            antiAliased ? "Anti-Aliasing: On" : "Anti-Aliasing: Off"
         };
-        if (gui.MakePopup("popup_edit", mnuEditItems, 4, mnuSelEdit)) {
+        if (MenuPopup("popup_edit", mnuEditItems, 9, mnuSelEdit)) {
             switch (mnuSelEdit) {
                 case 0: undoRedo.Undo(); break;
                 case 1: undoRedo.Redo(); break;
                 case 3: mnu_EditDeleteFigureAction(); break;
+                case 5: {
+                    bakedPlayback = !bakedPlayback;
+                    if (!bakedPlayback) poseCache.Clear();
+                } break;
+                case 6: {
+                    // every pose depends on the mode, baked ones included
+                    utils::SetFixedPointMode(!utils::GetFixedPointMode());
+                    poseCache.Clear();
+                    for (auto& fig : figures) fig->InvalidatePose();
+                    AnimateAll(currentFrame);
+                } break;
+                case 7: {
+                    // everything inline on the main thread, for debugging
+                    scheduler.SetThreadCount(scheduler.IsSingleThreaded() ? TaskScheduler::DefaultThreadCount() : 0);
+                } break;
+                case 8: antiAliased = !antiAliased; break;
                 default: break;
 			}
         }
 
-        if (gui.MakePopup("popup_figure_edit", mnuFigureEditorItems.data(), mnuFigureEditorItems.size(), mnuSelFigure)) {
+        if (MenuPopup("popup_figure_edit", mnuFigureEditorItems.data(), mnuFigureEditorItems.size(), mnuSelFigure)) {
             switch (mnuSelFigure) {
                 case 2: {
 #ifdef _WIN32
@@ -319,7 +385,7 @@ public:
         std::string mnuAboutItems[] = {
 			"About \"StickMator\""
 		};
-        if (gui.MakePopup("popup_about", mnuAboutItems, 1, selectedMenu)) {
+        if (MenuPopup("popup_about", mnuAboutItems, 1, selectedMenu)) {
             tinyfd_messageBox(
                 "About StickMator",
                     "StickMator is a simple stickman animation tool written in C++ using the olcPixelGameEngine.\n"
@@ -355,12 +421,13 @@ public:
         }
 
         if (playing) {
-            AnimateAll(currentFrame);
+            // interpolate between frames at the display rate
+            AnimateAll(float(currentFrame) + std::min(timer * FrameRate, 1.0f));
 
             timer += fElapsedTime;
             if (timer >= 1.0f / FrameRate) {
                 timer = 0.0f;
-                if (currentFrame++ >= MaxFramesAll()) {
+                if (currentFrame++ >= maxFrames) {
                     currentFrame = 0;
                 }
             }
@@ -371,7 +438,7 @@ public:
             if (oldPos != selectedStick->pos || oldAngle != selectedStick->angle) {
                 undoRedo.AddCommand(
                     new MoveStickCommand(
-                        selectedStick,
+                        this, selectedStick,
                         oldPos, oldAngle,
                         selectedStick->pos, selectedStick->angle
                     )
@@ -381,14 +448,29 @@ public:
         }
 
         prevMouse = mousePosRel;
+
+        // an open popup only goes away on a click, the next frame repairs what it covered
+        if (popupShown && (GetMouse(0).bPressed || GetMouse(0).bReleased)) popupClosing = true;
         return true;
     }
 
-    void DrawFigure(Figure& figure, const olc::vi2d& offset) {
-        DrawFigure(figure, olc::BLANK, offset);
-	}
+    void ShowMenu(const std::string& name) {
+        gui.ShowPopup(name);
+        popupShown = true;
+    }
 
-    void DrawOnionSkin(Figure& figure, const olc::vi2d& offset) {
+    bool MenuPopup(const std::string& name, std::string* items, size_t numItems, size_t& selected) {
+        if (!gui.MakePopup(name, items, numItems, selected)) return false;
+        popupShown = false;
+        popupClosing = true;
+        return true;
+    }
+
+    static uint64_t CanvasLayerKey(const Figure& figure, bool onionSkin) {
+        return (uint64_t(uint32_t(figure.id)) << 1) | (onionSkin ? 1 : 0);
+    }
+
+    void SubmitOnionSkin(Figure& figure) {
         if (playing) return;
 
         auto& fig = *figure.root;
@@ -398,38 +480,93 @@ public:
         };
         const olc::Pixel colors[] = { olc::Pixel(133, 161, 255), olc::Pixel(255, 153, 153) };
 
+        // ghosts are drawn from a snapshot, the live pose is never touched.
+        // They only change with the frame shown, the keyframes or the live pose they start from,
+        // whose transformRevision also follows the rig and the evaluation mode
+        auto& skin = onionSkins[figure.id];
+
         int i = 0;
         for (int frame : framesToDraw) {
-            fig.SaveState();
-            AnimateAllFigureSticks(figure, frame);
-            DrawFigure(figure, colors[i++], offset, false);
-            fig.RestoreState();
+            const olc::Pixel& color = colors[i++];
+            const bool changed = skin.frame != frame || skin.animationRevision != figure.animationRevision
+                || skin.transformRevision != figure.transformRevision;
+            if (changed) skin.revision++;
+
+            auto shapes = canvas.AddLayer(CanvasLayerKey(figure, true), skin.revision);
+            if (!shapes) continue;
+
+            const StickPose* pose = bakedPlayback ? poseCache.GetPose(figure, frame) : nullptr;
+            if (!pose) {
+                figure.EvaluatePose(frame, onionPose);
+                pose = onionPose.sticks.data();
+            }
+            figure.CollectPoseShapes(pose, *shapes, antiAliased, color);
+
+            skin.frame = frame;
+            skin.animationRevision = figure.animationRevision;
+            skin.transformRevision = figure.transformRevision;
         }
     }
 
-    void AnimateAllFigureSticks(Figure& fig, int frame) {
-        auto sticks = fig.root->GetSticksRecursiveSorted();
-        for (auto stk : sticks) {
-            stk->Animate(frame);
+    void AnimateAll(int frame) {
+        if (bakedPlayback) {
+            poseCache.Update(figures, MaxFramesAll() + 1);
         }
+
+        // figures don't share any mutable state, so each one can be posed on its own thread
+        scheduler.ParallelFor(0, figures.size(), [&](size_t i) {
+            Figure& fig = *figures[i];
+            if (!bakedPlayback || !poseCache.Apply(fig, frame)) {
+                fig.Animate(frame);
+            }
+        });
+	}
+
+    Stick* FindStick(int figureId, size_t stickId) {
+        for (auto& fig : figures) {
+            if (fig->id == figureId) return fig->FindStick(stickId);
+        }
+        return nullptr;
     }
 
-    void AnimateAll(int frame) {
-		for (auto& fig : figures) {
-            AnimateAllFigureSticks(*fig, frame);
-		}
+    void AnimateAll(float time) {
+        const int frame = int(std::floor(time));
+        if (time == float(frame)) {
+            AnimateAll(frame);
+            return;
+        }
+
+        if (bakedPlayback) {
+            poseCache.Update(figures, MaxFramesAll() + 1);
+        }
+
+        // between baked frames the rows on either side are blended, no keyframes are touched
+        scheduler.ParallelFor(0, figures.size(), [&](size_t i) {
+            Figure& fig = *figures[i];
+            if (!bakedPlayback || !poseCache.Apply(fig, time)) {
+                fig.Animate(time);
+            }
+        });
 	}
 
+    void UpdateAllTransforms() {
+        scheduler.ParallelFor(0, figures.size(), [&](size_t i) {
+            figures[i]->UpdateTransforms();
+        });
+    }
+
     int MaxFramesAll() {
         int maxFrames = 0;
 		for (auto& fig : figures) {
-			maxFrames = std::max(maxFrames, fig->root->MaxFrames());
+			maxFrames = std::max(maxFrames, fig->MaxFrames());
 		}
 		return maxFrames;
 	}
 
-    void DrawFigure(Figure& fig, olc::Pixel color, const olc::vi2d& offset = { 0, 0 }, bool manipulate = true) {
-        auto sticks = fig.root->GetSticksRecursiveVisibleSorted();
+    // picks the stick under the mouse and draws the selected figure's manipulators over the canvas.
+    // Expects the figure's transforms to be up to date, see UpdateAllTransforms
+    void ManipulateFigure(Figure& fig, const olc::vi2d& offset) {
+        auto& sticks = fig.GetSticksVisibleSorted();
         bool selected = selectedStick && selectedStick->GetRoot() == fig.root.get();
 
         for (auto stk : sticks) {
@@ -451,24 +588,39 @@ public:
             if (stick) break;
         }
 
-        for (auto stk : sticks) {
-            stk->Draw(this, nullptr, offset, color);
-        }
-
-        if (!playing && manipulate && selected) {
+        if (!playing && selected) {
+            // the handles (radius 2) sit on the sticks' ends, the canvas copies them away next frame
+            olc::vi2d min = fig.root->WorldPos(), max = min;
             for (auto stk : sticks) {
                 stk->DrawManipulators(this, offset);
+                for (const olc::vi2d& p : { stk->WorldPos(), stk->WorldPos() + stk->Tip() }) {
+                    min = min.min(p);
+                    max = max.max(p);
+                }
             }
+            canvas.MarkOverdrawn(min - olc::vi2d{ 3, 3 }, max - min + olc::vi2d{ 7, 7 });
         }
     }
 
-    void act_FigureLoadFile(const std::string& fileName) {
-        CommandFile cf{};
-        cf.LoadFromFile(fileName);
+    std::shared_ptr<const std::vector<Command>> LoadFigureFile(const std::string& fileName) {
+        std::error_code err;
+        auto writeTime = std::filesystem::last_write_time(fileName, err);
 
+        auto& entry = figureFileCache[fileName];
+        if (!entry.commands || entry.writeTime != writeTime || err) {
+            CommandFile cf{};
+            cf.LoadFromFile(fileName);
+            entry.commands = std::make_shared<const std::vector<Command>>(cf.GetCommands());
+            entry.writeTime = writeTime;
+        }
+        return entry.commands;
+    }
+
+    void act_FigureLoadFile(const std::string& fileName) {
         undoRedo.AddCommand(
-			new AddFigureCommand(this, cf.GetCommands())
+			new AddFigureCommand(this, LoadFigureFile(fileName))
 		)->Execute();
+        ShowLoadWarnings(figures.back()->loadWarnings);
 
         currentFrame = 0;
         AnimateAll(currentFrame);
@@ -509,6 +661,19 @@ public:
         return 2;
     }
 
+    // tells what a load dropped from the file, before a save can overwrite it without
+    void ShowLoadWarnings(const std::vector<std::string>& warnings) {
+        if (warnings.empty()) return;
+
+        std::string message = "Parts of the file could not be used and will be left out when it is saved:\n";
+        for (auto& warning : warnings) message += "\n" + warning;
+        // the dialogs refuse messages with quotes, figure names may have them
+        std::replace(message.begin(), message.end(), '\'', '`');
+        std::replace(message.begin(), message.end(), '"', '`');
+
+        tinyfd_messageBox("StickMator", message.c_str(), "ok", "warning", 0);
+    }
+
     void act_FileNew() {
         timer = 0.0f;
         currentFrame = 0;
@@ -683,27 +848,13 @@ public:
 	}
 
     void LoadAnimation(const std::string& fileName) {
-        CommandFile cf{};
-        cf.LoadFromFile(fileName);
-
-        std::vector<Command> commands = cf.GetCommands();
-        for (size_t i = 0; i < commands.size(); i++) {
-            auto& cmd = commands[i];
-            if (cmd.name == "fig") {
-                std::vector<Command> newCommands;
-                while (i < commands.size() && commands[i].name != "figend") {
-                    newCommands.push_back(commands[i++]);
-				}
-
-                auto figure = std::make_shared<Figure>();
-                figure->id = gFigureId++;
-				figure->LoadFromCommands(newCommands);
-				figures.push_back(figure);
-			}
-            else if (cmd.name == "figend") {
-                continue;
-            }
-		}
+        std::vector<std::string> warnings;
+        for (auto& figure : Figure::LoadAnimation(fileName)) {
+            figure->id = gFigureId++;
+            figures.push_back(figure);
+            warnings.insert(warnings.end(), figure->loadWarnings.begin(), figure->loadWarnings.end());
+        }
+        ShowLoadWarnings(warnings);
 	}
 
     void SaveGIF(const std::string& fileName) {
@@ -712,26 +863,15 @@ public:
         GifWriter gif;
         GifBegin(&gif, fileName.c_str(), gScreenWidth, gScreenHeight, delay);
 
-        olc::Sprite* buf = new olc::Sprite(gScreenWidth, gScreenHeight);
-        SetDrawTarget(buf);
-
-        for (int frame = 0; frame < MaxFramesAll(); frame++) {
-			Clear(olc::WHITE);
-			AnimateAll(frame);
-
-            for (auto& fig : figures) {
-                DrawFigure(*fig.get(), olc::BLANK, {0, 0}, false);
-            }
-
-            GifWriteFrame(&gif, (uint8_t*)GetDrawTarget()->GetData(), gScreenWidth, gScreenHeight, delay);
-		}
-
-        SetDrawTarget(nullptr);
+        // rendered offscreen, the engine's draw target is left alone
+        olc::Sprite buf(gScreenWidth, gScreenHeight);
+        OffscreenRenderer renderer(&scheduler);
+        renderer.SetAntiAliased(antiAliased);
+        renderer.RenderAnimation(figures, buf, MaxFramesAll(), [&](int) {
+            GifWriteFrame(&gif, (uint8_t*)buf.GetData(), gScreenWidth, gScreenHeight, delay);
+        });
 
         GifEnd(&gif);
-
-        AnimateAll(currentFrame);
-        delete buf;
 	}
 
     float timer = 0.0f;
@@ -751,6 +891,44 @@ public:
     bool stickMoved = false;
     bool playing{ false }, isSaved{false}, moving{false};
 
+    // parsed figure files, so loading the same figure again skips the parser
+    struct CachedFigureFile {
+        std::filesystem::file_time_type writeTime;
+        std::shared_ptr<const std::vector<Command>> commands;
+    };
+    std::unordered_map<std::string, CachedFigureFile> figureFileCache{};
+
+    // poses baked per frame, so playback copies instead of interpolating
+    PoseCache poseCache{};
+    bool bakedPlayback{ false };
+
+    // scratch snapshot for the onion skin
+    Pose onionPose{};
+
+    // what each figure's onion skin layer was collected from, by figure id
+    struct OnionSkin {
+        int frame{ -1 };
+        unsigned animationRevision{ 0 };
+        uint64_t transformRevision{ 0 };
+        uint64_t revision{ 0 };
+    };
+    std::unordered_map<int, OnionSkin> onionSkins{};
+
+    // evaluates figures in parallel, drawing stays on the UI thread
+    TaskScheduler scheduler{};
+
+    // smooth sub-pixel sticks in the viewport and exported GIFs
+    bool antiAliased{ false };
+
+    // the viewport's figures and onion skins, kept between frames
+    ViewportCanvas canvas{ gScreenWidth, gScreenHeight };
+
+    // the viewport needs repainting when it moves or a popup drawn over it goes away.
+    // TinyGUI draws popups after the update and doesn't tell when one closes: popupShown is set when one
+    // opens and cleared when an item is picked, a click outside of it closes it without notice
+    Rect lastViewportArea{ 0, 0, 0, 0 };
+    bool popupShown{ false }, popupClosing{ false };
+
     olc::vi2d oldPos{ 0, 0 };
     double oldAngle{ 0.0 };
 
@@ -785,7 +963,7 @@ int APIENTRY WinMain(
 void AddFigureCommand::Execute() {
     figure = std::make_shared<Figure>();
     figure->id = savedId == -1 ? app->gFigureId++ : savedId;
-    figure->LoadFromCommands(commands);
+    figure->LoadFromCommands(*commands);
     app->figures.push_back(figure);
 
     rootPos = { gScreenWidth / 2, gScreenHeight / 2 };
@@ -841,11 +1019,19 @@ void DelFigureCommand::Undo() {
 }
 
 void MoveStickCommand::Execute() {
+    Stick* stick = app->FindStick(figureId, stickId);
+    if (!stick) return;
+
     stick->pos = pos;
     stick->angle = angle;
+    if (stick->figure) stick->figure->InvalidatePose();
 }
 
 void MoveStickCommand::Undo() {
+    Stick* stick = app->FindStick(figureId, stickId);
+    if (!stick) return;
+
     stick->pos = prevPos;
     stick->angle = prevAngle;
+    if (stick->figure) stick->figure->InvalidatePose();
 }
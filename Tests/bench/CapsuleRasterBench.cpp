@@ -0,0 +1,89 @@
+// Per-frame raster time of the sample animations' sticks, highlight and stroke, drawn as scanline
+// capsules (DrawThickLine today) and as the FillCircle stamps DrawThickLine used before.
+
+#include "BenchUtil.h"
+
+#include <Raster.h>
+#include <Stick.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+    struct ReferenceEngine : olc::PixelGameEngine {
+        bool OnUserCreate() override { return true; }
+    };
+
+    struct Segment {
+        olc::vi2d start, end;
+    };
+
+    // DrawThickLine before the capsule rasterizer
+    void StampThickLine(olc::PixelGameEngine* pge, const olc::vi2d& p1, const olc::vi2d& p2, const olc::Pixel& color, int width) {
+        auto steps = (p2 - p1).mag() / width;
+        auto fp1 = olc::vf2d{ p1 };
+        auto fp2 = olc::vf2d{ p2 };
+        for (int i = 0; i < steps; i++) {
+            float fac = float(i) / steps;
+            pge->FillCircle(fp1.lerp(fp2, fac), width, color);
+        }
+    }
+
+    // the line sticks of every frame of an animation
+    std::vector<std::vector<Segment>> CollectFrames(const std::string& path) {
+        auto figures = Figure::LoadAnimation(path);
+        int frameCount = 0;
+        for (auto& figure : figures) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        std::vector<std::vector<Segment>> frames(frameCount);
+        for (int frame = 0; frame < frameCount; frame++) {
+            for (auto& figure : figures) {
+                figure->Animate(frame);
+                figure->UpdateTransforms();
+                for (Stick* stick : figure->GetSticksVisibleSorted()) {
+                    if (stick->isCircle) continue;
+                    frames[frame].push_back({ stick->WorldPos(), stick->WorldPos() + stick->Tip() });
+                }
+            }
+        }
+        return frames;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : SAMPLES_DIR;
+
+    ReferenceEngine engine;
+    olc::Sprite target(320, 240);
+    engine.SetDrawTarget(&target);
+
+    for (const char* name : { "walk.stk", "claw_anim.stk", "wonky_arrow.stk" }) {
+        const auto frames = CollectFrames(dir + "/" + name);
+        if (frames.empty()) continue;
+
+        auto drawAll = [&](auto&& drawLine) {
+            return bench::BestMilliseconds(20, [&] {
+                for (auto& segments : frames) {
+                    for (auto& segment : segments) {
+                        drawLine(segment, olc::BLUE, 4);
+                        drawLine(segment, olc::BLACK, 3);
+                    }
+                }
+                bench::Consume(target);
+            });
+        };
+
+        double stamped = drawAll([&](const Segment& s, const olc::Pixel& color, int width) {
+            StampThickLine(&engine, s.start, s.end, color, width);
+        });
+        double capsules = drawAll([&](const Segment& s, const olc::Pixel& color, int width) {
+            utils::FillCapsule(&engine, s.start, s.end, float(width) + 0.5f, color);
+        });
+
+        std::printf("%s, %zu frames\n", name, frames.size());
+        bench::Report("  FillCircle stamps", stamped, double(frames.size()), "frame");
+        bench::Report("  scanline capsules", capsules, double(frames.size()), "frame");
+    }
+    return 0;
+}
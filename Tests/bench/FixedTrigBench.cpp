@@ -0,0 +1,83 @@
+// Fixed-point mode's sine table against libm: sine and cosine per angle, then whole-crowd rig evaluation
+// in floating point and in fixed point.
+
+#include "BenchUtil.h"
+
+#include <FixedTrig.h>
+#include <Stick.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : SAMPLES_DIR;
+    constexpr size_t Count = 1 << 20;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> turn(-12.5, 12.5);
+    std::vector<double> radians(Count);
+    std::vector<int32_t> units(Count);
+    for (size_t i = 0; i < Count; i++) {
+        radians[i] = turn(rng);
+        units[i] = utils::ToAngleUnits(radians[i]);
+    }
+
+    std::printf("%zu angles\n", Count);
+    const double libm = bench::BestMilliseconds(5, [&] {
+        double sum = 0.0;
+        for (size_t i = 0; i < Count; i++) sum += std::sin(radians[i]) + std::cos(radians[i]);
+        bench::Consume(sum);
+    });
+    bench::Report("std::sin + std::cos", libm, double(Count), "angle");
+
+    const double table = bench::BestMilliseconds(5, [&] {
+        int64_t sum = 0;
+        for (size_t i = 0; i < Count; i++) {
+            int32_t sine, cosine;
+            utils::SinCosQ30(units[i], sine, cosine);
+            sum += sine + cosine;
+        }
+        bench::Consume(sum);
+    });
+    bench::Report("SinCosQ30", table, double(Count), "angle");
+    std::printf("%40s %.2fx\n", "speedup over libm", libm / table);
+
+    // a crowd of walkers, evaluated every frame of the walk
+    constexpr int Copies = 200;
+    std::vector<std::shared_ptr<Figure>> crowd;
+    for (int c = 0; c < Copies; c++) {
+        for (auto& figure : Figure::LoadAnimation(dir + "/walk.stk")) crowd.push_back(figure);
+    }
+    int frameCount = 0;
+    size_t sticks = 0;
+    for (auto& figure : crowd) {
+        frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+        figure->UpdateTransforms();
+        sticks += figure->GetRig().Size();
+    }
+
+    std::printf("%d figures, %zu sticks, %d frames\n", int(crowd.size()), sticks, frameCount);
+    double evaluation[2] = {};
+    for (bool fixedPoint : { false, true }) {
+        utils::SetFixedPointMode(fixedPoint);
+        evaluation[fixedPoint] = bench::BestMilliseconds(5, [&] {
+            for (int frame = 0; frame < frameCount; frame++) {
+                for (auto& figure : crowd) {
+                    figure->Animate(frame);
+                    figure->UpdateTransforms();
+                }
+            }
+            bench::Consume(crowd.back()->GetRig().tip);
+        });
+        bench::Report(fixedPoint ? "animate + evaluate, fixed point" : "animate + evaluate, floating point",
+            evaluation[fixedPoint], double(sticks) * frameCount, "stick");
+    }
+    std::printf("%40s %.2fx\n", "fixed point over floating point", evaluation[0] / evaluation[1]);
+
+    utils::SetFixedPointMode(false);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Keyframe segment lookup on a synthetic 10k keyframe track: forward playback and scrubbing through
+// Stick::Animate (playback cursor), random seeks (binary search), and the full scan Animate used to do.
+
+#include "BenchUtil.h"
+
+#include <Stick.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr int KeyCount = 10000;
+    constexpr int KeySpacing = 3;
+    constexpr int FrameCount = (KeyCount - 1) * KeySpacing;
+
+    // Animate before the binary search: every segment is tested on every call
+    void AnimateLinear(Stick& stick, int frame) {
+        auto& animation = stick.animation;
+        for (size_t i = 0; i + 1 < animation.size(); i++) {
+            auto& skf = animation[i];
+            auto& ekf = animation[i + 1];
+            if (frame >= skf.frame && frame < ekf.frame) {
+                float t = float(frame - skf.frame) / (ekf.frame - skf.frame);
+                stick.angle = utils::LerpAngle(skf.angle, ekf.angle, t);
+                stick.pos = olc::vf2d{ skf.pos }.lerp(olc::vf2d{ ekf.pos }, t);
+            }
+        }
+    }
+}
+
+int main() {
+    auto stick = std::make_unique<Stick>();
+    stick->len = 40;
+    for (int i = 0; i < KeyCount; i++) {
+        stick->AppendKeyframe(i * KeySpacing, olc::vi2d{ i % 97, i % 89 }, (i % 360) * 0.0174532925);
+    }
+    stick->SortKeyframes();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> anyFrame(0, FrameCount - 1);
+    std::vector<int> seeks(FrameCount);
+    for (auto& frame : seeks) frame = anyFrame(rng);
+
+    // scrubbing: a frame or two back and forth around a slowly moving point
+    std::vector<int> scrub(FrameCount);
+    for (int i = 0; i < FrameCount; i++) scrub[i] = std::max(0, i / 2 + (i % 3) - 1);
+
+    std::printf("%d keyframes, %d frames\n", KeyCount, FrameCount);
+
+    double linear = bench::BestMilliseconds(1, [&] {
+        for (int frame = 0; frame < FrameCount; frame++) AnimateLinear(*stick, frame);
+        bench::Consume(stick->angle);
+    });
+    bench::Report("full scan, forward playback", linear, FrameCount, "frame");
+
+    double playback = bench::BestMilliseconds(5, [&] {
+        for (int frame = 0; frame < FrameCount; frame++) stick->Animate(frame);
+        bench::Consume(stick->angle);
+    });
+    bench::Report("cursor, forward playback", playback, FrameCount, "frame");
+
+    double scrubbing = bench::BestMilliseconds(5, [&] {
+        for (int frame : scrub) stick->Animate(frame);
+        bench::Consume(stick->angle);
+    });
+    bench::Report("cursor, scrubbing", scrubbing, FrameCount, "frame");
+
+    double seeking = bench::BestMilliseconds(5, [&] {
+        for (int frame : seeks) stick->Animate(frame);
+        bench::Consume(stick->angle);
+    });
+    bench::Report("binary search, random seeks", seeking, FrameCount, "frame");
+
+    // both lookups must land on the same pose
+    int mismatches = 0;
+    auto reference = std::make_unique<Stick>();
+    reference->animation.assign(stick->animation.begin(), stick->animation.end());
+    for (int frame : seeks) {
+        stick->Animate(frame);
+        AnimateLinear(*reference, frame);
+        if (stick->angle != reference->angle || stick->pos != reference->pos) mismatches++;
+    }
+    std::printf("speedup over full scan: %.0fx playback, %.0fx random seeks; %d mismatching poses\n",
+        linear / playback, linear / seeking, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
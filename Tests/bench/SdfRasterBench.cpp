@@ -0,0 +1,125 @@
+// The distance-field blend on every SIMD level the CPU supports: stick-sized capsule spans at 1x and
+// 4x scale, then whole anti-aliased frames of a crowd of walkers on one core, at preview size and scaled
+// up for export.
+
+#include "BenchUtil.h"
+
+#include <OffscreenRenderer.h>
+#include <SdfRaster.h>
+#include <SimdTrig.h>
+#include <Stick.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Span {
+        int capsule, y, x0, x1;
+    };
+
+    // rows of random sticks around 30 pixels long and 8 wide, times scale, each row clipped to the
+    // capsule's bounds plus a pixel of anti-aliasing
+    void MakeSticks(float scale, std::vector<utils::SdfCapsule>& capsules, std::vector<Span>& spans) {
+        std::mt19937 rng(24);
+        std::uniform_real_distribution<float> coordinate(0.0f, 200.0f), turn(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> length(10.0f, 50.0f), radius(2.5f, 5.0f);
+
+        capsules.clear();
+        spans.clear();
+        for (int i = 0; i < 2000; i++) {
+            const olc::vf2d a{ coordinate(rng) * scale, coordinate(rng) * scale };
+            const float angle = turn(rng), len = length(rng) * scale, r = radius(rng) * scale;
+            const olc::vf2d b = a + olc::vf2d{ std::cos(angle), std::sin(angle) } * len;
+            capsules.emplace_back(a, b, r);
+
+            const int top = int(std::floor(std::min(a.y, b.y) - r - 1)), bottom = int(std::ceil(std::max(a.y, b.y) + r + 1));
+            const int left = int(std::floor(std::min(a.x, b.x) - r - 1)), right = int(std::ceil(std::max(a.x, b.x) + r + 1));
+            for (int y = top; y <= bottom; y++) spans.push_back({ i, y, left, right });
+        }
+    }
+
+    const char* LevelName(utils::SimdLevel level) {
+        switch (level) {
+            case utils::SimdLevel::AVX2: return "AVX2";
+            case utils::SimdLevel::SSE4: return "SSE4.1";
+            default: return "scalar";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : SAMPLES_DIR;
+    const utils::SimdLevel detected = utils::GetSimdLevel();
+    const utils::SimdLevel levels[] = { utils::SimdLevel::Scalar, utils::SimdLevel::SSE4, utils::SimdLevel::AVX2 };
+
+    std::vector<utils::SdfCapsule> capsules;
+    std::vector<Span> spans;
+    for (float scale : { 1.0f, 4.0f }) {
+        MakeSticks(scale, capsules, spans);
+        size_t pixels = 0, widest = 0;
+        for (const Span& s : spans) {
+            pixels += size_t(s.x1 - s.x0 + 1);
+            widest = std::max(widest, size_t(s.x1 - s.x0 + 1));
+        }
+        std::vector<olc::Pixel> row(widest, olc::WHITE);
+        const olc::Pixel color{ 40, 60, 200, 230 };
+
+        std::printf("%zu sticks at %gx scale, %zu spans, %zu pixels\n", capsules.size(), scale, spans.size(), pixels);
+        double scalar = 0.0;
+        for (auto level : levels) {
+            utils::SetSimdLevel(level);
+            if (utils::GetSimdLevel() != level) continue;
+            const double ms = bench::BestMilliseconds(10, [&] {
+                for (const Span& s : spans) utils::BlendCapsuleSpan(row.data(), s.y, s.x0, s.x1, capsules[s.capsule], color);
+                bench::Consume(row);
+            });
+            if (level == utils::SimdLevel::Scalar) scalar = ms;
+            bench::Report(LevelName(level), ms, double(pixels), "pixel");
+            if (level != utils::SimdLevel::Scalar) std::printf("%40s %.2fx\n", "speedup over scalar", scalar / ms);
+        }
+    }
+
+    // a crowd of walkers, anti-aliased on the calling thread like the viewport without workers
+    constexpr int Copies = 80;
+    std::vector<std::shared_ptr<Figure>> crowd;
+    for (int c = 0; c < Copies; c++) {
+        for (auto& figure : Figure::LoadAnimation(dir + "/walk.stk")) crowd.push_back(figure);
+    }
+    int frameCount = 0;
+    for (auto& figure : crowd) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+    for (float scale : { 1.0f, 4.0f }) {
+        OffscreenRenderer renderer;
+        renderer.SetAntiAliased(true);
+        renderer.SetScale(scale);
+        olc::Sprite target(int(320 * scale), int(240 * scale));
+
+        std::printf("%d figures, %d frames, %dx%d\n", int(crowd.size()), frameCount, target.width, target.height);
+        double scalar = 0.0;
+        for (auto level : levels) {
+            utils::SetSimdLevel(level);
+            if (utils::GetSimdLevel() != level) continue;
+            const double ms = bench::BestMilliseconds(5, [&] {
+                for (int frame = 0; frame < frameCount; frame++) {
+                    for (auto& figure : crowd) {
+                        figure->Animate(frame);
+                        figure->UpdateTransforms();
+                    }
+                    renderer.Render(crowd, target);
+                }
+                bench::Consume(target);
+            });
+            if (level == utils::SimdLevel::Scalar) scalar = ms;
+            bench::Report(LevelName(level), ms, double(frameCount), "frame");
+            std::printf("%40s %.2f ms\n", "per frame", ms / frameCount);
+            if (level != utils::SimdLevel::Scalar) std::printf("%40s %.2fx\n", "speedup over scalar", scalar / ms);
+        }
+    }
+
+    utils::SetSimdLevel(detected);
+    return 0;
+}
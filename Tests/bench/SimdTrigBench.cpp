@@ -0,0 +1,47 @@
+// Tip throughput of the batched trigonometry kernel at each SIMD level, on a crowd-sized batch of angles.
+
+#include "BenchUtil.h"
+
+#include <SimdTrig.h>
+
+#include <random>
+#include <vector>
+
+int main() {
+    constexpr size_t Count = 1 << 20;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> turn(-12.5, 12.5);
+    std::uniform_int_distribution<int> length(1, 200);
+    std::vector<double> angles(Count);
+    std::vector<int> lengths(Count);
+    std::vector<olc::vi2d> tips(Count);
+    for (size_t i = 0; i < Count; i++) {
+        angles[i] = turn(rng);
+        lengths[i] = length(rng);
+    }
+
+    std::printf("%zu sticks\n", Count);
+    const utils::SimdLevel detected = utils::GetSimdLevel();
+    const char* names[] = { "scalar std::cos/std::sin", "SSE4", "AVX2" };
+    double scalar = 0.0;
+
+    for (auto level : { utils::SimdLevel::Scalar, utils::SimdLevel::SSE4, utils::SimdLevel::AVX2 }) {
+        utils::SetSimdLevel(level);
+        if (utils::GetSimdLevel() != level) {
+            std::printf("%s not supported\n", names[int(level)]);
+            continue;
+        }
+
+        double ms = bench::BestMilliseconds(5, [&] {
+            utils::ComputeTips(angles.data(), lengths.data(), tips.data(), Count);
+            bench::Consume(tips);
+        });
+        if (level == utils::SimdLevel::Scalar) scalar = ms;
+        bench::Report(names[int(level)], ms, double(Count), "tip");
+        std::printf("%40s %.2fx\n", "speedup over scalar", scalar / ms);
+    }
+
+    utils::SetSimdLevel(detected);
+    return 0;
+}
@@ -0,0 +1,18 @@
+# Runs two builds of the same dump program and fails unless both succeed with identical output.
+# Usage: cmake -DFIRST=<exe> -DSECOND=<exe> -DDATA_DIR=<dir> -P CompareOutputs.cmake
+
+foreach(EXE FIRST SECOND)
+    execute_process(
+        COMMAND ${${EXE}} ${DATA_DIR}
+        OUTPUT_VARIABLE ${EXE}_OUTPUT
+        RESULT_VARIABLE ${EXE}_RESULT
+    )
+    message("${${EXE}}:\n${${EXE}_OUTPUT}")
+    if(NOT ${EXE}_RESULT EQUAL 0)
+        message(FATAL_ERROR "${${EXE}} failed: ${${EXE}_RESULT}")
+    endif()
+endforeach()
+
+if(NOT FIRST_OUTPUT STREQUAL SECOND_OUTPUT)
+    message(FATAL_ERROR "The builds disagree")
+endif()
@@ -0,0 +1,172 @@
+// Dumps a digest of everything fixed-point mode computes for the sample animations: angle rounding,
+// rig evaluation, baked ranges, live and baked sub-frame poses and the pixels of every exported frame. Built twice with different optimization and
+// floating-point contraction flags, the two dumps must be identical. Within one build every SIMD
+// level must give the same digest, and the sticks' own transforms must match the rig.
+
+#include <FixedTrig.h>
+#include <OffscreenRenderer.h>
+#include <PoseCache.h>
+#include <SimdTrig.h>
+#include <Stick.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // FNV-1a over the integers fixed-point mode produces
+    struct Digest {
+        uint64_t value{ 14695981039346656037ull };
+
+        void Add(int64_t v) {
+            for (int i = 0; i < 8; i++) {
+                value ^= uint64_t(v >> (i * 8)) & 0xff;
+                value *= 1099511628211ull;
+            }
+        }
+        void Add(const olc::vi2d& v) {
+            Add(v.x);
+            Add(v.y);
+        }
+        void AddAngle(double radians) { Add(utils::ToAngleUnits(radians)); }
+        void Add(const olc::Sprite& sprite) {
+            for (const olc::Pixel& p : sprite.pColData) Add(int64_t(p.n));
+        }
+    };
+
+    uint64_t RoundingDigest() {
+        Digest digest;
+        std::mt19937_64 rng(2024);
+        std::uniform_real_distribution<double> angle(-40.0, 40.0);
+        std::uniform_real_distribution<double> factor(-4.0, 4.0);
+        for (int i = 0; i < 1000000; i++) {
+            digest.Add(utils::ToAngleUnits(angle(rng)));
+            digest.Add(utils::ToFixedQ16(factor(rng)));
+        }
+
+        // Products landing just off a rounding boundary, where a fused multiply-add would round
+        // differently from a multiply then an add. Random values almost never get that close.
+        const double unitsPerRadian = utils::AngleUnitsPerTurn / (2.0 * Pi);
+        for (int k = -20000; k <= 20000; k++) {
+            for (double offset : { 0.5, 0.5 - 0x1p-22, 0.5 + 0x1p-22, 0.5 - 0x1p-23 }) {
+                double radians = (k + offset) / unitsPerRadian;
+                for (int ulp = 0; ulp < 4; ulp++) {
+                    digest.Add(utils::ToAngleUnits(radians));
+                    digest.Add(utils::ToFixedQ16(radians));
+                    radians = std::nextafter(radians, 1e300);
+                }
+            }
+        }
+        return digest.value;
+    }
+
+    uint64_t AnimationDigest(const std::string& path, int& mismatches) {
+        Digest digest;
+        auto figures = Figure::LoadAnimation(path);
+        int frameCount = 0;
+        for (auto& figure : figures) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        for (auto& figure : figures) {
+            Rig& rig = figure->GetRig();
+
+            // baked rows
+            std::vector<StickPose> start(rig.Size()), rows(rig.Size() * frameCount);
+            figure->CapturePose(start.data());
+            figure->EvaluateRange(0, frameCount, start.data(), rows.data());
+            for (auto& pose : rows) {
+                digest.Add(pose.pos);
+                digest.AddAngle(pose.angle);
+            }
+
+            // live playback at whole and sub frames, through the rig and through the sticks
+            for (int frame = 0; frame < frameCount; frame++) {
+                for (float fraction : { 0.0f, 0.5f }) {
+                    figure->Animate(float(frame) + fraction);
+                    figure->UpdateTransforms();
+                    for (size_t i = 0; i < rig.Size(); i++) {
+                        digest.Add(rig.worldPos[i]);
+                        digest.Add(rig.tip[i]);
+                        digest.AddAngle(rig.worldAngle[i]);
+                    }
+
+                    // the editors' per-stick path has to agree with the rig
+                    figure->root->UpdateTransforms();
+                    for (size_t i = 0; i < rig.Size(); i++) {
+                        const Stick* stick = rig.sticks[i];
+                        if (stick->cachedWorldPos != rig.worldPos[i] || stick->cachedTip != rig.tip[i]
+                            || stick->cachedWorldAngle != rig.worldAngle[i]) mismatches++;
+                    }
+                }
+            }
+        }
+
+        // baked playback between frames
+        PoseCache cache;
+        cache.Update(figures, frameCount);
+        for (auto& figure : figures) {
+            Rig& rig = figure->GetRig();
+            for (int frame = 0; frame < frameCount; frame++) {
+                for (float fraction : { 0.25f, 0.5f }) {
+                    cache.Apply(*figure, float(frame) + fraction);
+                    figure->UpdateTransforms();
+                    for (size_t i = 0; i < rig.Size(); i++) {
+                        digest.Add(rig.worldPos[i]);
+                        digest.AddAngle(rig.worldAngle[i]);
+                    }
+                }
+            }
+        }
+        return digest.value;
+    }
+
+    // the frames an export writes, drawn the way it draws them
+    uint64_t ExportDigest(const std::string& path, bool antiAliased) {
+        Digest digest;
+        auto figures = Figure::LoadAnimation(path);
+        int frameCount = 0;
+        for (auto& figure : figures) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        OffscreenRenderer renderer;
+        renderer.SetAntiAliased(antiAliased);
+        olc::Sprite target(320, 240);
+        renderer.RenderAnimation(figures, target, frameCount, [&](int) { digest.Add(target); });
+        return digest.value;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string dir = argc > 1 ? argv[1] : ".";
+    utils::SetFixedPointMode(true);
+
+    std::printf("rounding %016llx\n", (unsigned long long)RoundingDigest());
+
+    int failures = 0;
+    for (const char* name : { "walk.stk", "claw_anim.stk", "wonky_arrow.stk" }) {
+        uint64_t first = 0;
+        bool any = false;
+        for (auto level : { utils::SimdLevel::Scalar, utils::SimdLevel::SSE4, utils::SimdLevel::AVX2 }) {
+            utils::SetSimdLevel(level);
+            if (utils::GetSimdLevel() != level) continue;
+
+            int mismatches = 0;
+            Digest digest;
+            digest.Add(int64_t(AnimationDigest(dir + "/" + name, mismatches)));
+            digest.Add(int64_t(ExportDigest(dir + "/" + name, false)));
+            digest.Add(int64_t(ExportDigest(dir + "/" + name, true)));
+            if (mismatches) {
+                std::printf("%s: %d stick transforms differ from the rig\n", name, mismatches);
+                failures++;
+            }
+            if (any && digest.value != first) {
+                std::printf("%s: SIMD level %d differs\n", name, int(level));
+                failures++;
+            }
+            first = any ? first : digest.value;
+            any = true;
+        }
+        std::printf("%s %016llx\n", name, (unsigned long long)first);
+    }
+    return failures == 0 ? 0 : 1;
+}
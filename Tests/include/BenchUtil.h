@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Timing for the benchmark executables: runs a body a few times and keeps the fastest run,
+// which is the least disturbed by the rest of the machine.
+namespace bench {
+    template<typename F>
+    double BestMilliseconds(int runs, F&& body) {
+        double best = 1e300;
+        for (int run = 0; run < runs; run++) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    inline void Report(const char* name, double milliseconds, double items, const char* unit) {
+        std::printf("%-40s %10.3f ms %12.1f ns/%s\n", name, milliseconds, milliseconds * 1e6 / items, unit);
+    }
+
+    // keeps the optimizer from dropping work whose result is otherwise unused:
+    // the value has to be in memory, where anything may read it
+    template<typename T>
+    inline void Consume(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+}
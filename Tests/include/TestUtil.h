@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// Minimal checks for the test executables: failed checks are reported and counted,
+// and the test's main returns test::Finish() so ctest sees the failure.
+namespace test {
+    inline int& Failures() {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline bool Check(bool condition, const char* expression, const char* file, int line) {
+        if (!condition) {
+            std::printf("%s:%d: check failed: %s\n", file, line, expression);
+            Failures()++;
+        }
+        return condition;
+    }
+
+    // the sample files directory, passed by ctest as the first argument
+    inline std::string DataPath(int argc, char** argv, const std::string& fileName) {
+        const std::string dir = argc > 1 ? argv[1] : ".";
+        return dir + "/" + fileName;
+    }
+
+    inline int Finish(const char* name) {
+        if (Failures() == 0) {
+            std::printf("%s: passed\n", name);
+            return 0;
+        }
+        std::printf("%s: %d check(s) failed\n", name, Failures());
+        return 1;
+    }
+}
+
+#define CHECK(condition) test::Check((condition), #condition, __FILE__, __LINE__)
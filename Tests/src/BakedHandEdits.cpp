@@ -0,0 +1,45 @@
+// A stick posed by hand outside of any keyframe track keeps its pose in baked playback, like it does
+// in live playback, once the edit is reported with Figure::InvalidatePose as MoveStickCommand does.
+
+#include "TestUtil.h"
+
+#include <PoseCache.h>
+#include <Stick.h>
+
+#include <cmath>
+#include <memory>
+
+int main() {
+    auto figure = std::make_shared<Figure>();
+    figure->Reset();
+    Stick& keyed = figure->root->AddChild(20, 0.0);
+    Stick& loose = keyed.AddChild(15, 0.5);
+    keyed.SetKeyframeSingle(0, keyed.pos, 0.0);
+    keyed.SetKeyframeSingle(10, keyed.pos, 1.0);
+
+    const std::vector<std::shared_ptr<Figure>> figures{ figure };
+    constexpr int FrameCount = 12;
+    PoseCache cache;
+    cache.Update(figures, FrameCount);
+    CHECK(cache.Apply(*figure, 5));
+    CHECK(loose.angle == 0.5);
+
+    // by hand, at some frame
+    loose.angle = 2.0;
+    loose.pos = olc::vi2d{ 3, 4 };
+    figure->InvalidatePose();
+    cache.Update(figures, FrameCount);
+
+    for (int frame = 0; frame < FrameCount; frame++) {
+        CHECK(cache.Apply(*figure, frame));
+        CHECK(loose.angle == 2.0 && loose.pos == olc::vi2d(3, 4));
+        CHECK(cache.Apply(*figure, float(frame) + 0.5f));
+        CHECK(loose.angle == 2.0 && loose.pos == olc::vi2d(3, 4));
+    }
+
+    // the keyed stick still follows its track
+    CHECK(cache.Apply(*figure, 5));
+    CHECK(std::abs(keyed.angle - 0.5) < 1e-6);
+
+    return test::Finish("BakedHandEdits");
+}
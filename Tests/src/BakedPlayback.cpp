@@ -0,0 +1,83 @@
+// Baked playback between frames: PoseCache::Apply at fractional times must pose the figures like
+// Figure::Animate(float), in floating and fixed point, so smooth playback can stay on the baked rows.
+
+#include "TestUtil.h"
+
+#include <FixedTrig.h>
+#include <PoseCache.h>
+#include <Stick.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    void CheckAnimation(const std::string& path, bool fixedPoint) {
+        utils::SetFixedPointMode(fixedPoint);
+
+        auto baked = Figure::LoadAnimation(path);
+        auto live = Figure::LoadAnimation(path);
+        int frameCount = 0;
+        for (auto& figure : baked) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        PoseCache cache;
+        cache.Update(baked, frameCount);
+
+        // float interpolation factors, or a unit of rounding in fixed point
+        const double angleTolerance = fixedPoint ? 2.0 * Pi / utils::AngleUnitsPerTurn * 1.5 : 1e-6;
+        int applied = 0, angleMismatches = 0, posMismatches = 0;
+
+        for (int frame = 0; frame < frameCount; frame++) {
+            for (auto& figure : live) figure->Animate(frame);
+
+            for (float fraction : { 0.0f, 0.25f, 0.5f, 0.75f }) {
+                const float time = float(frame) + fraction;
+                for (size_t f = 0; f < baked.size(); f++) {
+                    live[f]->Animate(time);
+                    if (!cache.Apply(*baked[f], time)) continue;
+                    applied++;
+
+                    auto& expected = live[f]->GetRig().sticks;
+                    auto& actual = baked[f]->GetRig().sticks;
+                    for (size_t i = 0; i < expected.size(); i++) {
+                        // Only inside the stick's track. Whole-frame playback holds from the last segment on,
+                        // so the blend holds too instead of heading for a final key that is never shown,
+                        // while live sub-frame playback leaves the stick wherever the last sub-frame put it.
+                        const Stick& stick = *expected[i];
+                        const int blendEnd = fraction != 0.0f ? frame + 1 : frame;
+                        if (stick.animation.size() < 2 || blendEnd >= stick.animation.back().frame) continue;
+
+                        if (std::abs(actual[i]->angle - expected[i]->angle) > angleTolerance) angleMismatches++;
+                        const olc::vi2d d = actual[i]->pos - expected[i]->pos;
+                        if (std::abs(d.x) > 1 || std::abs(d.y) > 1) posMismatches++;
+                    }
+                }
+            }
+        }
+
+        CHECK(applied == frameCount * 4 * int(baked.size()));
+        CHECK(angleMismatches == 0);
+        CHECK(posMismatches == 0);
+
+        // a whole frame after a blended one is the baked row again
+        if (frameCount > 1) {
+            cache.Apply(*baked[0], 0.5f);
+            CHECK(cache.Apply(*baked[0], 1));
+            const StickPose* row = cache.GetPose(*baked[0], 1);
+            auto& sticks = baked[0]->GetRig().sticks;
+            for (size_t i = 0; i < sticks.size(); i++) {
+                CHECK(sticks[i]->angle == row[i].angle && sticks[i]->pos == row[i].pos);
+            }
+        }
+
+        utils::SetFixedPointMode(false);
+    }
+}
+
+int main(int argc, char** argv) {
+    for (const char* name : { "walk.stk", "claw_anim.stk", "wonky_arrow.stk" }) {
+        for (bool fixedPoint : { false, true }) {
+            CheckAnimation(test::DataPath(argc, argv, name), fixedPoint);
+        }
+    }
+    return test::Finish("BakedPlayback");
+}
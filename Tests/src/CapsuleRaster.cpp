@@ -0,0 +1,108 @@
+// Checks the scanline capsule rasterizer against a brute-force distance test, and that FillCapsule
+// paints exactly those pixels, clipped to the draw target.
+
+#include "TestUtil.h"
+
+#include <Raster.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    // squared distance from pixel center (x, y) to segment [a, b], in long double so ties show up as ties
+    long double DistanceSq(int x, int y, const olc::vi2d& a, const olc::vi2d& b) {
+        const long double dx = b.x - a.x, dy = b.y - a.y;
+        const long double px = x - a.x, py = y - a.y;
+        const long double lengthSq = dx * dx + dy * dy;
+        long double t = lengthSq > 0 ? (px * dx + py * dy) / lengthSq : 0;
+        t = std::clamp(t, (long double)0, (long double)1);
+        const long double ex = px - t * dx, ey = py - t * dy;
+        return ex * ex + ey * ey;
+    }
+
+    // pixels exactly on the rim may go either way
+    bool OnRim(long double distanceSq, float radius) {
+        return std::abs(distanceSq - (long double)radius * radius) < 1e-6L;
+    }
+
+    struct ReferenceEngine : olc::PixelGameEngine {
+        bool OnUserCreate() override { return true; }
+    };
+
+    int CountSpanMismatches(const olc::vi2d& a, const olc::vi2d& b, float radius) {
+        const utils::Capsule capsule(a, b, radius);
+        int mismatches = 0;
+        const int margin = 3;
+
+        for (int y = capsule.top - margin; y <= capsule.bottom + margin; y++) {
+            int x0 = 0, x1 = -1;
+            bool any = capsule.Span(y, x0, x1);
+            if (y < capsule.top || y > capsule.bottom) {
+                if (any) mismatches++;
+                continue;
+            }
+
+            const int left = std::min(a.x, b.x) - int(radius) - margin;
+            const int right = std::max(a.x, b.x) + int(radius) + margin;
+            for (int x = left; x <= right; x++) {
+                const long double distanceSq = DistanceSq(x, y, a, b);
+                const bool covered = any && x >= x0 && x <= x1;
+                if (covered != (distanceSq <= (long double)radius * radius) && !OnRim(distanceSq, radius)) mismatches++;
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main() {
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> coordinate(-40, 40);
+    std::uniform_real_distribution<float> anyRadius(0.0f, 12.0f);
+
+    int spanMismatches = 0;
+    for (int i = 0; i < 4000; i++) {
+        olc::vi2d a{ coordinate(rng), coordinate(rng) };
+        olc::vi2d b{ coordinate(rng), coordinate(rng) };
+        // the stick stroke and highlight radii, then anything
+        for (float radius : { 3.5f, 4.5f, anyRadius(rng) }) {
+            spanMismatches += CountSpanMismatches(a, b, radius);
+        }
+    }
+
+    // degenerate segments: points, horizontal and vertical
+    for (int length = 0; length <= 20; length++) {
+        for (float radius : { 0.0f, 0.5f, 3.5f, 4.5f }) {
+            spanMismatches += CountSpanMismatches({ 0, 0 }, { length, 0 }, radius);
+            spanMismatches += CountSpanMismatches({ 0, 0 }, { 0, -length }, radius);
+        }
+    }
+    CHECK(spanMismatches == 0);
+
+    // FillCapsule paints the covered pixels inside the target and nothing else, including when clipped
+    ReferenceEngine engine;
+    olc::Sprite target(64, 48);
+    engine.SetDrawTarget(&target);
+
+    int fillMismatches = 0;
+    std::uniform_int_distribution<int> around(-20, 84);
+    for (int i = 0; i < 500; i++) {
+        olc::vi2d a{ around(rng), around(rng) };
+        olc::vi2d b{ around(rng), around(rng) };
+        const float radius = 3.5f;
+
+        engine.Clear(olc::WHITE);
+        utils::FillCapsule(&engine, a, b, radius, olc::BLACK);
+
+        for (int y = 0; y < target.height; y++) {
+            for (int x = 0; x < target.width; x++) {
+                const long double distanceSq = DistanceSq(x, y, a, b);
+                const bool painted = target.GetPixel(x, y) == olc::BLACK;
+                if (painted != (distanceSq <= (long double)radius * radius) && !OnRim(distanceSq, radius)) fillMismatches++;
+            }
+        }
+    }
+    CHECK(fillMismatches == 0);
+
+    return test::Finish("CapsuleRaster");
+}
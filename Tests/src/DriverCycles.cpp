@@ -0,0 +1,118 @@
+// Driver cycles from a file or from the stick tree must not stop a figure from loading or compiling:
+// the link closing the cycle is dropped and reported, the stick keeps its own angle, and only sticks
+// something still follows remain drivers.
+
+#include "TestUtil.h"
+
+#include <Stick.h>
+
+#include <cmath>
+
+namespace {
+    const char* CyclicFigure = R"(
+fig Cycles
+s 101 10 30 normal false "#000000" false true 0
+s 102 10 60 normal false "#000000" false true 0
+s 103 10 90 normal false "#000000" false true 0
+s 104 10 0 normal false "#000000" false true 0
+r 0 101
+r 101 102
+r 0 103
+r 103 104
+d 101 102 1 0
+d 102 101 1 0
+d 103 103 1 0
+d 104 101 -1 0
+figend Cycles
+)";
+
+    bool Finite(Rig& rig) {
+        for (size_t i = 0; i < rig.Size(); i++) {
+            if (!std::isfinite(rig.worldAngle[i])) return false;
+        }
+        return true;
+    }
+
+    // a stick is a driver, in the tree and in the compiled rig, exactly when another stick follows it
+    bool DriverFlagsMatch(Rig& rig) {
+        for (size_t i = 0; i < rig.Size(); i++) {
+            const Stick* stick = rig.sticks[i];
+            bool followed = false;
+            for (const Stick* other : rig.sticks) followed = followed || other->driver == stick;
+            if (stick->isDriver != followed) return false;
+            if (bool(rig.definition.flags[i] & RigDriver) != followed) return false;
+        }
+        return true;
+    }
+}
+
+int main() {
+    // from a file: the links closing a cycle are dropped as they are read
+    {
+        Figure figure;
+        bool loaded = true;
+        try {
+            figure.LoadFromString(CyclicFigure);
+        }
+        catch (const std::exception&) {
+            loaded = false;
+        }
+        CHECK(loaded);
+
+        Stick* a = figure.FindStick(101);
+        Stick* b = figure.FindStick(102);
+        Stick* self = figure.FindStick(103);
+        Stick* downstream = figure.FindStick(104);
+        CHECK(a && b && self && downstream);
+        if (a && b && self && downstream) {
+            CHECK(a->driver == b);
+            CHECK(b->driver == nullptr);
+            CHECK(self->driver == nullptr);
+            CHECK(downstream->driver == a);
+            CHECK(std::isfinite(downstream->Angle()));
+        }
+
+        // each dropped link is reported, the kept ones aren't
+        CHECK(figure.loadWarnings.size() == 2);
+        for (auto& warning : figure.loadWarnings) CHECK(warning.find("driver cycle") != std::string::npos);
+        CHECK(figure.loadWarnings.size() == 2 && figure.loadWarnings[0].find("stick 102") != std::string::npos);
+        CHECK(figure.loadWarnings.size() == 2 && figure.loadWarnings[1].find("stick 103") != std::string::npos);
+
+        // and a load that drops nothing reports nothing
+        figure.LoadFromString(figure.Save().SaveToString());
+        CHECK(figure.loadWarnings.empty());
+
+        Rig& rig = figure.GetRig();
+        CHECK(rig.definition.driveOrder.size() == rig.Size());
+        CHECK(DriverFlagsMatch(rig));
+        figure.UpdateTransforms();
+        CHECK(Finite(rig));
+    }
+
+    // built by hand past the checks: compiling cuts one link of the cycle and keeps the rest
+    {
+        Figure figure;
+        figure.LoadFromString(CyclicFigure);
+        Stick* a = figure.FindStick(101);
+        Stick* b = figure.FindStick(102);
+        Stick* c = figure.FindStick(103);
+        Stick* downstream = figure.FindStick(104);
+        a->driver = b;
+        b->driver = c;
+        c->driver = a;
+        c->isDriver = true;
+        figure.Invalidate();
+
+        Rig& rig = figure.GetRig();
+        CHECK(rig.definition.driveOrder.size() == rig.Size());
+        CHECK((a->driver == nullptr) + (b->driver == nullptr) + (c->driver == nullptr) == 1);
+        CHECK(downstream->driver == a);
+        CHECK(DriverFlagsMatch(rig));
+
+        figure.UpdateTransforms();
+        CHECK(Finite(rig));
+        CHECK(std::isfinite(downstream->Angle()));
+    }
+
+    return test::Finish("DriverCycles");
+}
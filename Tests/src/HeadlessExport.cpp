@@ -0,0 +1,96 @@
+// Renders the sample animations offscreen and exports them as GIFs, linked against the headless
+// core only: no window, display, X11 or GL. Frames must match drawing through a PixelGameEngine.
+
+#include "TestUtil.h"
+
+#include <OffscreenRenderer.h>
+#include <Stick.h>
+
+#include <gif.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    constexpr int Width = 320;
+    constexpr int Height = 240;
+
+    // the engine is only used as a draw target, it is never constructed into a window
+    struct ReferenceEngine : olc::PixelGameEngine {
+        bool OnUserCreate() override { return true; }
+    };
+
+    bool SamePoses(const Pose& a, const Pose& b) {
+        if (a.Size() != b.Size()) return false;
+        for (size_t i = 0; i < a.Size(); i++) {
+            if (a.sticks[i].pos != b.sticks[i].pos || a.sticks[i].angle != b.sticks[i].angle) return false;
+        }
+        return true;
+    }
+
+    void ExportAnimation(const std::string& path) {
+        auto figures = Figure::LoadAnimation(path);
+        auto reference = Figure::LoadAnimation(path);
+        CHECK(!figures.empty());
+
+        int frameCount = 0;
+        for (auto& figure : figures) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        std::vector<Pose> before(figures.size());
+        for (size_t i = 0; i < figures.size(); i++) figures[i]->CapturePose(before[i]);
+
+        const auto gifPath = std::filesystem::temp_directory_path() / (std::filesystem::path(path).stem().string() + "_headless.gif");
+        GifWriter gif;
+        CHECK(GifBegin(&gif, gifPath.string().c_str(), Width, Height, 100 / FrameRate));
+
+        olc::Sprite frame(Width, Height), expected(Width, Height);
+        ReferenceEngine engine;
+        OffscreenRenderer renderer;
+        int rendered = 0, mismatches = 0;
+
+        renderer.RenderAnimation(figures, frame, frameCount, [&](int index) {
+            engine.SetDrawTarget(&expected);
+            engine.Clear(olc::WHITE);
+            for (auto& figure : reference) {
+                figure->Animate(index);
+                figure->UpdateTransforms();
+                figure->Draw(&engine);
+            }
+            if (!std::equal(frame.pColData.begin(), frame.pColData.end(), expected.pColData.begin())) mismatches++;
+
+            GifWriteFrame(&gif, reinterpret_cast<const uint8_t*>(frame.GetData()), Width, Height, 100 / FrameRate);
+            rendered++;
+        });
+        CHECK(GifEnd(&gif));
+
+        CHECK(rendered == frameCount);
+        CHECK(mismatches == 0);
+
+        // the figures are back in the pose they were in
+        for (size_t i = 0; i < figures.size(); i++) {
+            Pose after;
+            figures[i]->CapturePose(after);
+            CHECK(SamePoses(before[i], after));
+        }
+
+        char header[6] = {};
+        std::ifstream(gifPath, std::ios::binary).read(header, sizeof(header));
+        CHECK(std::string(header, sizeof(header)) == "GIF89a");
+        std::filesystem::remove(gifPath);
+
+        // anti-aliased and scaled up, something has to land on the canvas
+        renderer.SetAntiAliased(true);
+        renderer.SetScale(2.0f);
+        olc::Sprite large(Width * 2, Height * 2);
+        renderer.Render(figures, large);
+        CHECK(std::any_of(large.pColData.begin(), large.pColData.end(), [](const olc::Pixel& p) { return p != olc::WHITE; }));
+    }
+}
+
+int main(int argc, char** argv) {
+    for (const char* file : { "claw_anim.stk", "walk.stk", "wonky_arrow.stk" }) {
+        ExportAnimation(test::DataPath(argc, argv, file));
+    }
+    return test::Finish("HeadlessExport");
+}
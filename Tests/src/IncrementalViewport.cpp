@@ -0,0 +1,145 @@
+// Plays an animation through the viewport canvas the way StickMator does, collecting only figures whose
+// transforms changed (with an onion skin evaluated in the same rig) and presenting only what was redrawn
+// or drawn over, and checks every frame on the screen against the same frame collected, redrawn and
+// presented from scratch with a separately loaded copy.
+
+#include "TestUtil.h"
+
+#include <Stick.h>
+#include <TaskScheduler.h>
+#include <ViewportCanvas.h>
+
+#include <algorithm>
+
+namespace {
+    constexpr int Width = 320, Height = 240;
+    const olc::vi2d Position{ 40, 30 };
+    const olc::Pixel Junk{ 255, 0, 255 };
+    const olc::Pixel Ghost{ 133, 161, 255 };
+    constexpr int GhostFrame = 0;
+
+    size_t CountMismatches(const olc::Sprite& screen, const olc::Sprite& reference) {
+        size_t mismatches = 0;
+        for (int y = 0; y < screen.height; y++) {
+            for (int x = 0; x < screen.width; x++) {
+                if (screen.GetPixel(x, y) != reference.GetPixel(x, y)) mismatches++;
+            }
+        }
+        return mismatches;
+    }
+
+    void CheckAnimation(const std::string& path, bool antiAliased) {
+        auto figures = Figure::LoadAnimation(path);
+        auto reference = Figure::LoadAnimation(path);
+        CHECK(!figures.empty() && figures.size() == reference.size());
+
+        // per figure: the transformRevision the ghost was collected at, and the ghost layer's revision
+        std::vector<uint64_t> ghostFrom(figures.size(), ~uint64_t(0)), ghostRevision(figures.size(), 0);
+        Pose pose;
+
+        TaskScheduler scheduler(0);
+        ViewportCanvas canvas(Width, Height);
+        canvas.SetAntiAliased(antiAliased);
+
+        olc::Sprite screen(Width + 80, Height + 60);
+        std::fill_n(screen.GetData(), size_t(screen.width) * screen.height, Junk);
+
+        int lastFrame = 0;
+        for (auto& fig : figures) lastFrame = std::max(lastFrame, fig->MaxFrames());
+
+        size_t presented = 0, frames = 0;
+        for (int step = 0; step <= lastFrame * 2 + 2; step++) {
+            // every frame is shown twice, the second time nothing moves
+            const int frame = step / 2;
+            for (size_t i = 0; i < figures.size(); i++) {
+                figures[i]->id = int(i);
+                figures[i]->Animate(frame);
+                figures[i]->UpdateTransforms();
+            }
+
+            size_t collected = 0;
+            canvas.BeginFrame();
+            for (size_t i = 0; i < figures.size(); i++) {
+                Figure& fig = *figures[i];
+                if (ghostFrom[i] != fig.transformRevision) {
+                    ghostFrom[i] = fig.transformRevision;
+                    ghostRevision[i]++;
+                }
+                if (auto shapes = canvas.AddLayer(uint64_t(i) * 2 + 1, ghostRevision[i])) {
+                    fig.EvaluatePose(GhostFrame, pose);
+                    fig.CollectPoseShapes(pose.sticks.data(), *shapes, antiAliased, Ghost);
+                    collected++;
+                }
+            }
+            for (size_t i = 0; i < figures.size(); i++) {
+                Figure& fig = *figures[i];
+                if (auto shapes = canvas.AddLayer(uint64_t(i) * 2, fig.transformRevision)) {
+                    fig.UpdateTransforms();
+                    fig.CollectShapes(*shapes, antiAliased);
+                    collected++;
+                }
+            }
+            canvas.EndFrame(scheduler);
+
+            // something drawn over the canvas, like the manipulators, is copied away by the next Present
+            if (step % 5 == 3) {
+                const olc::vi2d at{ 30 + step % 200, 20 + step % 150 }, size{ 17, 9 };
+                for (int y = 0; y < size.y; y++) {
+                    for (int x = 0; x < size.x; x++) {
+                        screen.SetPixel(Position + at + olc::vi2d{ x, y }, Junk);
+                    }
+                }
+                canvas.MarkOverdrawn(at, size);
+            }
+            canvas.Present(screen, Position);
+
+            if (step > 0 && step % 2 == 1) {
+                CHECK(collected == 0);
+                if (step % 5 != 3) CHECK(canvas.PresentedPixels() == 0);
+            }
+            if (step > 0) {
+                presented += canvas.PresentedPixels();
+                frames++;
+            }
+
+            // the same frame from scratch, on a screen that only has the canvas. The live shapes are
+            // collected before the ghost is evaluated, so they never depend on UpdateTransforms noticing it
+            std::vector<std::vector<StickShape>> ghosts(reference.size()), live(reference.size());
+            for (size_t i = 0; i < reference.size(); i++) {
+                Figure& fig = *reference[i];
+                fig.Animate(frame);
+                fig.UpdateTransforms();
+                fig.CollectShapes(live[i], antiAliased);
+                fig.EvaluatePose(GhostFrame, pose);
+                fig.CollectPoseShapes(pose.sticks.data(), ghosts[i], antiAliased, Ghost);
+            }
+
+            ViewportCanvas fresh(Width, Height);
+            fresh.SetAntiAliased(antiAliased);
+            fresh.BeginFrame();
+            for (size_t i = 0; i < reference.size(); i++) *fresh.AddLayer(uint64_t(i) * 2 + 1, 0) = ghosts[i];
+            for (size_t i = 0; i < reference.size(); i++) *fresh.AddLayer(uint64_t(i) * 2, 0) = live[i];
+            fresh.EndFrame(scheduler);
+
+            olc::Sprite expected(screen.width, screen.height);
+            std::fill_n(expected.GetData(), size_t(expected.width) * expected.height, Junk);
+            fresh.Present(expected, Position);
+
+            if (!CHECK(CountMismatches(screen, expected) == 0)) {
+                std::printf("  %s, frame %d (step %d), anti-aliased %d\n", path.c_str(), frame, step, int(antiAliased));
+                return;
+            }
+        }
+
+        // a walk doesn't cover the whole viewport every frame
+        CHECK(frames > 0 && presented < frames * size_t(Width) * Height / 2);
+    }
+}
+
+int main(int argc, char** argv) {
+    for (bool antiAliased : { false, true }) {
+        CheckAnimation(test::DataPath(argc, argv, "walk.stk"), antiAliased);
+        CheckAnimation(test::DataPath(argc, argv, "claw_anim.stk"), antiAliased);
+    }
+    return test::Finish("IncrementalViewport");
+}
@@ -0,0 +1,93 @@
+// Reloads figures of a different size into a baked PoseCache, including a new figure at the address
+// of a deleted one (File > Open after File > Open), and checks the bake follows the new figure.
+
+#include "TestUtil.h"
+
+#include <CommandFile.h>
+#include <PoseCache.h>
+#include <Stick.h>
+
+#include <new>
+
+namespace {
+    // the commands of the first figure of an animation file
+    std::vector<Command> FirstFigure(const std::string& path) {
+        CommandFile cf{};
+        cf.LoadFromFile(path);
+
+        std::vector<Command> commands;
+        bool inFigure = false;
+        for (auto& cmd : cf.GetCommands()) {
+            if (cmd.name == "fig") inFigure = true;
+            else if (cmd.name == "figend" && inFigure) break;
+            if (inFigure) commands.push_back(cmd);
+        }
+        return commands;
+    }
+
+    // every baked frame holds what sequential Animate calls give on a fresh copy of the figure
+    int CountBakeMismatches(const PoseCache& cache, const Figure& figure, const std::vector<Command>& commands) {
+        Figure reference;
+        reference.LoadFromCommands(commands);
+
+        int mismatches = 0;
+        std::vector<StickPose> expected(reference.GetRig().Size());
+        for (int frame = 0; frame < cache.FrameCount(); frame++) {
+            reference.Animate(frame);
+            reference.CapturePose(expected.data());
+
+            const StickPose* baked = cache.GetPose(figure, frame);
+            if (!baked) {
+                mismatches++;
+                continue;
+            }
+            for (size_t i = 0; i < expected.size(); i++) {
+                if (baked[i].pos != expected[i].pos || baked[i].angle != expected[i].angle) mismatches++;
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main(int argc, char** argv) {
+    const auto claw = FirstFigure(test::DataPath(argc, argv, "claw_anim.stk"));
+    const auto walker = FirstFigure(test::DataPath(argc, argv, "walk.stk"));
+
+    Figure probe;
+    probe.LoadFromCommands(claw);
+    const size_t clawSize = probe.GetRig().Size();
+    probe.LoadFromCommands(walker);
+    CHECK(clawSize != probe.GetRig().Size());
+
+    // a figure always constructed at the same address, as the allocator may do after a delete
+    alignas(Figure) unsigned char storage[sizeof(Figure)];
+    auto place = [&](const std::vector<Command>& commands) {
+        auto figure = std::shared_ptr<Figure>(new (storage) Figure(), [](Figure* f) { f->~Figure(); });
+        figure->LoadFromCommands(commands);
+        return figure;
+    };
+
+    PoseCache cache;
+    const int frameCount = 40;
+    {
+        std::vector<std::shared_ptr<Figure>> figures{ place(claw) };
+        cache.Update(figures, frameCount);
+        CHECK(CountBakeMismatches(cache, *figures[0], claw) == 0);
+    }
+
+    // the old figure is gone, a bigger one lives at the same address
+    {
+        std::vector<std::shared_ptr<Figure>> figures{ place(walker) };
+        CHECK(cache.GetPose(*figures[0], 0) == nullptr);
+        cache.Update(figures, frameCount);
+        CHECK(CountBakeMismatches(cache, *figures[0], walker) == 0);
+
+        // and back to the smaller one, reloaded into the same object
+        figures[0]->LoadFromCommands(claw);
+        cache.Update(figures, frameCount);
+        CHECK(CountBakeMismatches(cache, *figures[0], claw) == 0);
+        CHECK(cache.Apply(*figures[0], frameCount - 1));
+    }
+
+    return test::Finish("PoseCacheReload");
+}
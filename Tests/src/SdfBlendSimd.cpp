@@ -0,0 +1,142 @@
+// Checks that the SSE4.1 and AVX2 distance-field blends give the same pixels as the scalar blend, for
+// random capsules, colors and backgrounds on every span length up to a few vectors and every tail, that
+// nothing outside the span is written, and that whole anti-aliased frames agree on every level.
+
+#include "TestUtil.h"
+
+#include <OffscreenRenderer.h>
+#include <SdfRaster.h>
+#include <SimdTrig.h>
+#include <Stick.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr int Guard = 9;
+    const olc::Pixel GuardColor{ 1, 2, 3, 4 };
+
+    struct Case {
+        utils::SdfCapsule capsule;
+        olc::Pixel color;
+        int y, x0, x1;
+        std::vector<olc::Pixel> background;
+    };
+
+    olc::Pixel RandomPixel(std::mt19937& rng) {
+        std::uniform_int_distribution<int> channel(0, 255);
+        return olc::Pixel(channel(rng), channel(rng), channel(rng), channel(rng));
+    }
+
+    std::vector<Case> MakeCases() {
+        std::mt19937 rng(2024);
+        std::uniform_real_distribution<float> coordinate(-20.0f, 60.0f);
+        std::uniform_real_distribution<float> radius(0.0f, 12.0f);
+        std::uniform_int_distribution<int> shift(-8, 8), length(0, 40);
+
+        std::vector<Case> cases;
+        for (int i = 0; i < 20000; i++) {
+            const olc::vf2d a{ coordinate(rng), coordinate(rng) };
+            // one in eight is a circle, which has no length to project on
+            const olc::vf2d b = i % 8 == 0 ? a : olc::vf2d{ coordinate(rng), coordinate(rng) };
+            olc::Pixel color = RandomPixel(rng);
+            if (i % 5 == 0) color.a = 255;
+
+            // spans start a little either side of the capsule's left edge, on rows through it or just past it
+            const float r = radius(rng);
+            std::uniform_int_distribution<int> row(int(std::min(a.y, b.y) - r) - 2, int(std::max(a.y, b.y) + r) + 2);
+            const int x0 = int(std::min(a.x, b.x) - r) + shift(rng);
+            Case c{ utils::SdfCapsule(a, b, r), color, row(rng), x0, x0 + length(rng) - 1, {} };
+            for (int x = c.x0; x <= c.x1; x++) c.background.push_back(RandomPixel(rng));
+            cases.push_back(std::move(c));
+        }
+        return cases;
+    }
+
+    // the case blended into its background, with guard pixels on both sides of the span
+    std::vector<olc::Pixel> Blend(const Case& c) {
+        std::vector<olc::Pixel> pixels(Guard, GuardColor);
+        pixels.insert(pixels.end(), c.background.begin(), c.background.end());
+        pixels.insert(pixels.end(), Guard, GuardColor);
+        utils::BlendCapsuleSpan(pixels.data() + Guard, c.y, c.x0, c.x1, c.capsule, c.color);
+        return pixels;
+    }
+
+    bool GuardsIntact(const std::vector<olc::Pixel>& pixels) {
+        auto isGuard = [](const olc::Pixel& p) { return p == GuardColor; };
+        return std::all_of(pixels.begin(), pixels.begin() + Guard, isGuard)
+            && std::all_of(pixels.end() - Guard, pixels.end(), isGuard);
+    }
+
+    std::vector<olc::Pixel> RenderFrames(const std::string& path) {
+        auto figures = Figure::LoadAnimation(path);
+        int frameCount = 0;
+        for (auto& figure : figures) frameCount = std::max(frameCount, figure->MaxFrames() + 1);
+
+        OffscreenRenderer renderer;
+        renderer.SetAntiAliased(true);
+        renderer.SetScale(1.5f);
+        olc::Sprite frame(480, 360);
+        std::vector<olc::Pixel> frames;
+        renderer.RenderAnimation(figures, frame, frameCount, [&](int) {
+            frames.insert(frames.end(), frame.pColData.begin(), frame.pColData.end());
+        });
+        return frames;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::vector<Case> cases = MakeCases();
+    const utils::SimdLevel detected = utils::GetSimdLevel();
+
+    utils::SetSimdLevel(utils::SimdLevel::Scalar);
+    std::vector<std::vector<olc::Pixel>> expected;
+    size_t covered = 0;
+    for (const Case& c : cases) {
+        expected.push_back(Blend(c));
+        CHECK(GuardsIntact(expected.back()));
+        covered += !std::equal(c.background.begin(), c.background.end(), expected.back().begin() + Guard);
+    }
+    // enough of the spans cross their capsule for the comparison to mean something
+    CHECK(covered > cases.size() / 2);
+
+    // a point on the segment is fully covered, so an opaque color replaces the background
+    {
+        const utils::SdfCapsule capsule({ 2.0f, 5.0f }, { 30.0f, 5.0f }, 3.0f);
+        std::vector<olc::Pixel> span(16, olc::WHITE);
+        utils::BlendCapsuleSpan(span.data(), 5, 8, 23, capsule, olc::DARK_BLUE);
+        CHECK(std::all_of(span.begin(), span.end(), [](const olc::Pixel& p) { return p == olc::DARK_BLUE; }));
+        utils::BlendCapsuleSpan(span.data(), 20, 8, 23, capsule, olc::WHITE);
+        CHECK(std::all_of(span.begin(), span.end(), [](const olc::Pixel& p) { return p == olc::DARK_BLUE; }));
+    }
+
+    const std::vector<olc::Pixel> expectedFrames = RenderFrames(test::DataPath(argc, argv, "walk.stk"));
+    CHECK(!expectedFrames.empty());
+
+    for (auto level : { utils::SimdLevel::SSE4, utils::SimdLevel::AVX2 }) {
+        utils::SetSimdLevel(level);
+        if (utils::GetSimdLevel() != level) {
+            std::printf("SIMD level %d not supported, skipped\n", int(level));
+            continue;
+        }
+
+        int mismatches = 0;
+        for (size_t i = 0; i < cases.size(); i++) {
+            if (Blend(cases[i]) != expected[i]) {
+                if (mismatches < 5) {
+                    const Case& c = cases[i];
+                    std::printf("  level %d: row %d, span [%d, %d], capsule (%g, %g) + (%g, %g) radius %g\n", int(level),
+                        c.y, c.x0, c.x1, c.capsule.ax, c.capsule.ay, c.capsule.dx, c.capsule.dy, c.capsule.radius);
+                }
+                mismatches++;
+            }
+        }
+        CHECK(mismatches == 0);
+        CHECK(RenderFrames(test::DataPath(argc, argv, "walk.stk")) == expectedFrames);
+    }
+
+    utils::SetSimdLevel(detected);
+    return test::Finish("SdfBlendSimd");
+}
@@ -0,0 +1,102 @@
+// Checks the batched tip kernel against the scalar std::cos/std::sin tips on every instruction set
+// the CPU supports, including the angles where a vectorized result could truncate differently.
+
+#include "TestUtil.h"
+
+#include <SimdTrig.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr double Pi = 3.14159265358979323846;
+
+    olc::vi2d ReferenceTip(double angle, int len) {
+        if (len <= 0) return olc::vi2d{ 0, 0 };
+        return olc::vd2d{ std::cos(angle) * len, std::sin(angle) * len };
+    }
+
+    struct Batch {
+        std::vector<double> angles;
+        std::vector<int> lengths;
+
+        void Add(double angle, int len) {
+            angles.push_back(angle);
+            lengths.push_back(len);
+        }
+    };
+
+    Batch MakeBatch() {
+        Batch batch;
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<double> turn(-4.0 * Pi, 4.0 * Pi);
+        std::uniform_real_distribution<double> tiny(-1e-12, 1e-12);
+        std::uniform_real_distribution<double> huge(-2e6, 2e6);
+        std::uniform_int_distribution<int> length(-5, 400);
+
+        // the angles sticks usually have
+        for (int i = 0; i < 20000; i++) batch.Add(turn(rng), length(rng));
+
+        // quadrant boundaries, where one of the products lands on an integer
+        for (int k = -16; k <= 16; k++) {
+            for (int len : { 1, 7, 50, 333 }) {
+                batch.Add(k * Pi / 2, len);
+                batch.Add(k * Pi / 2 + tiny(rng), len);
+            }
+        }
+
+        // whole degrees, as the editor snaps them
+        for (int degrees = -720; degrees <= 720; degrees++) batch.Add(degrees * Pi / 180, 60);
+
+        // angles past the polynomial reduction range, which fall back to libm
+        for (int i = 0; i < 1000; i++) batch.Add(huge(rng), length(rng));
+
+        // an odd count, so the vector paths have a tail
+        batch.Add(0.5, 10);
+        return batch;
+    }
+
+    int CountMismatches(const Batch& batch, size_t offset, size_t count) {
+        std::vector<olc::vi2d> tips(count);
+        utils::ComputeTips(batch.angles.data() + offset, batch.lengths.data() + offset, tips.data(), count);
+
+        int mismatches = 0;
+        for (size_t i = 0; i < count; i++) {
+            olc::vi2d expected = ReferenceTip(batch.angles[offset + i], batch.lengths[offset + i]);
+            if (tips[i] != expected) {
+                if (mismatches < 5) {
+                    std::printf("  angle %.17g len %d: got (%d, %d), expected (%d, %d)\n",
+                        batch.angles[offset + i], batch.lengths[offset + i], tips[i].x, tips[i].y, expected.x, expected.y);
+                }
+                mismatches++;
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main() {
+    const Batch batch = MakeBatch();
+    const utils::SimdLevel detected = utils::GetSimdLevel();
+
+    for (auto level : { utils::SimdLevel::Scalar, utils::SimdLevel::SSE4, utils::SimdLevel::AVX2 }) {
+        utils::SetSimdLevel(level);
+        if (utils::GetSimdLevel() != level) {
+            std::printf("SIMD level %d not supported, skipped\n", int(level));
+            continue;
+        }
+
+        CHECK(CountMismatches(batch, 0, batch.angles.size()) == 0);
+
+        // every short count and unaligned start, to cover the remainders
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t count = 0; count <= 9; count++) {
+                CHECK(CountMismatches(batch, offset, count) == 0);
+            }
+        }
+    }
+
+    utils::SetSimdLevel(detected);
+    return test::Finish("SimdTrigAccuracy");
+}